@@ -0,0 +1,12 @@
+echo -e "Loader benchmark ....\n"
+# matriz2000 and matriz4000 are too big to be versioned, generate them
+for order in 2000 4000; do
+    if [ ! -f ../matrices/matriz$order.txt ]; then
+        echo -e "Generating matrix ${order}x${order}"
+        ../bin/generate $order ../matrices/matriz$order.txt
+    fi
+done
+for order in 1000 2000 4000; do
+    echo -e "\nMatrix ${order}x${order}"
+    ../bin/loadbench ../matrices/matriz$order.txt
+done
@@ -0,0 +1,20 @@
+echo -e "Benchmark ....\n"
+# Every engine and thread count on each matrix, appended to benchmark.csv and
+# benchmark.json in ../output/benchmark
+THREADS=${THREADS:-"1 2 4 8"}
+RESULTS=../output/benchmark
+mkdir -p $RESULTS
+for order in 250 500 1000; do
+    for engine in serial pthreads openmp; do
+        for threads in $THREADS; do
+            # The serial engine has a single thread
+            if [ $engine = serial ] && [ $threads != 1 ]; then
+                continue
+            fi
+            echo -e "\nMatrix ${order}x${order} $engine $threads threads"
+            ../bin/main ../matrices/matriz$order.txt $RESULTS/output${order}_${engine}_$threads \
+                --engine $engine -t $threads --load-once --warmup 2 --runs 10 \
+                --csv $RESULTS/benchmark.csv --json $RESULTS/benchmark.json
+        done
+    done
+done
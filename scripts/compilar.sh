@@ -1,3 +1,10 @@
-gcc ../src/main.c -o ../bin/main -lm
-gcc ../src/parallel.c -o ../bin/parallel -lpthread -lm
-gcc ../src/openmp.c -o ../bin/openmp -fopenmp -lm
+# Build the solver library and every program with CMake (see CMakeLists.txt)
+# and copy the programs to bin/. mpi is only built when MPI is found
+set -e
+cmake -S .. -B ../build
+cmake --build ../build -j
+for program in main parallel openmp mpi convert generate loadbench; do
+    if [ -f ../build/$program ]; then
+        cp ../build/$program ../bin/
+    fi
+done
@@ -0,0 +1,5 @@
+echo -e "Converting matrices to the binary format ....\n"
+for matrix in ../matrices/matriz*.txt; do
+    echo -e "$matrix -> ${matrix%.txt}.bin"
+    ../bin/convert "$matrix" "${matrix%.txt}.bin"
+done
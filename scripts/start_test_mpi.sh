@@ -0,0 +1,7 @@
+echo -e "Starting tests ....\n"
+echo -e "Matrix 1000x1000 2 ranks"
+mpirun -np 2 ../bin/mpi ../matrices/matriz1000.txt ../output/mpi/matrix1000/output1000_2
+echo -e "\nMatrix 1000x1000 4 ranks"
+mpirun -np 4 ../bin/mpi ../matrices/matriz1000.txt ../output/mpi/matrix1000/output1000_4
+echo -e "\nMatrix 1000x1000 4 ranks, overlapped exchange"
+mpirun -np 4 ../bin/mpi ../matrices/matriz1000.txt ../output/mpi/matrix1000/output1000_4_overlap --overlap
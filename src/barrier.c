@@ -0,0 +1,137 @@
+#include <stdlib.h>
+#include <limits.h>
+#include <time.h>
+#include <unistd.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#include "barrier.h"
+
+// Pause instructions spent spinning before sleeping on the futex
+#define SPIN_LIMIT 65536
+
+// Longest backoff between two reads of the sense flag
+#define MAX_BACKOFF 64
+
+static inline void cpuRelax(void){
+
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+static double now(void){
+
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+
+    return t.tv_sec + t.tv_nsec / 1000000000.0;
+}
+
+void barrierInit(Barrier *barrier, int numberOfThreads, BarrierKind kind){
+
+    int i;
+
+    if(kind == BARRIER_AUTO)
+        kind = numberOfThreads <= sysconf(_SC_NPROCESSORS_ONLN) ? BARRIER_SPIN : BARRIER_PTHREAD;
+
+    barrier->kind = kind;
+    barrier->numberOfThreads = numberOfThreads;
+    barrier->count = numberOfThreads;
+    barrier->sense = 0;
+    barrier->sleepers = 0;
+
+    posix_memalign((void**) &barrier->slots, sizeof(BarrierSlot), sizeof(BarrierSlot) * numberOfThreads);
+    for(i = 0; i < numberOfThreads; i++){
+        barrier->slots[i].sense = 0;
+        barrier->slots[i].waitTime = 0;
+    }
+
+    if(kind == BARRIER_PTHREAD)
+        pthread_barrier_init(&barrier->pthreadBarrier, NULL, numberOfThreads);
+}
+
+/**
+ * Sense-reversing crossing
+ */
+static int spinWait(Barrier *barrier, int thread){
+
+    int i, backoff;
+    int spins = 0;
+    int sense = !barrier->slots[thread].sense;
+
+    barrier->slots[thread].sense = sense;
+
+    // Last one in resets the count for the next crossing and releases the rest
+    if(__atomic_sub_fetch(&barrier->count, 1, __ATOMIC_ACQ_REL) == 0){
+        barrier->count = barrier->numberOfThreads;
+        __atomic_store_n(&barrier->sense, sense, __ATOMIC_SEQ_CST);
+        if(__atomic_load_n(&barrier->sleepers, __ATOMIC_SEQ_CST) > 0)
+            syscall(SYS_futex, &barrier->sense, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+
+        return PTHREAD_BARRIER_SERIAL_THREAD;
+    }
+
+    for(backoff = 1; spins < SPIN_LIMIT; backoff = backoff < MAX_BACKOFF ? backoff * 2 : backoff){
+        if(__atomic_load_n(&barrier->sense, __ATOMIC_ACQUIRE) == sense)
+            return 0;
+
+        for(i = 0; i < backoff; i++){
+            cpuRelax();
+        }
+        spins += backoff;
+
+        // Full backoff, let the threads still to arrive run if they share
+        // the CPU with this one
+        if(backoff == MAX_BACKOFF)
+            sched_yield();
+    }
+
+    // Waited long enough, sleep until the sense flips. The wait returns at
+    // once if it flipped after the last read
+    __atomic_add_fetch(&barrier->sleepers, 1, __ATOMIC_SEQ_CST);
+    while(__atomic_load_n(&barrier->sense, __ATOMIC_SEQ_CST) != sense)
+        syscall(SYS_futex, &barrier->sense, FUTEX_WAIT_PRIVATE, !sense, NULL, NULL, 0);
+    __atomic_sub_fetch(&barrier->sleepers, 1, __ATOMIC_SEQ_CST);
+
+    return 0;
+}
+
+int barrierWait(Barrier *barrier, int thread){
+
+    int r;
+    double start = now();
+
+    if(barrier->kind == BARRIER_SPIN)
+        r = spinWait(barrier, thread);
+    else
+        r = pthread_barrier_wait(&barrier->pthreadBarrier);
+
+    barrier->slots[thread].waitTime += now() - start;
+
+    return r;
+}
+
+void barrierResetWait(Barrier *barrier){
+
+    int i;
+
+    for(i = 0; i < barrier->numberOfThreads; i++){
+        barrier->slots[i].waitTime = 0;
+    }
+}
+
+const char* barrierName(const Barrier *barrier){
+
+    return barrier->kind == BARRIER_SPIN ? "spin" : "pthread";
+}
+
+void barrierDestroy(Barrier *barrier){
+
+    if(barrier->kind == BARRIER_PTHREAD)
+        pthread_barrier_destroy(&barrier->pthreadBarrier);
+
+    free(barrier->slots);
+}
@@ -0,0 +1,79 @@
+#ifndef BARRIER_H
+#define BARRIER_H
+
+#include <pthread.h>
+
+/**
+ * Barrier of the iteration loop
+ *
+ * BARRIER_PTHREAD wraps pthread_barrier_t, which puts the waiting threads to
+ * sleep on a futex every time. BARRIER_SPIN is a sense-reversing barrier:
+ * the last thread to arrive flips a shared sense flag and the others spin
+ * on it, backing off exponentially with pause instructions, so a crossing
+ * costs a cache line transfer instead of a wake up. A thread that spins for
+ * too long sleeps on the flag with a futex, so oversubscribed runs do not
+ * burn the CPU of the thread they are waiting for.
+ *
+ * Both kinds record the time each thread spends waiting.
+ */
+typedef enum {
+    BARRIER_AUTO,
+    BARRIER_PTHREAD,
+    BARRIER_SPIN
+} BarrierKind;
+
+/**
+ * Per-thread state, one cache line each
+ * sense: Sense of the current crossing, the spinning barrier only
+ * waitTime: Seconds spent in barrierWait since the last barrierResetWait
+ */
+typedef struct {
+    int sense;
+    double waitTime;
+    char padding[64 - sizeof(int) - sizeof(double)];
+} __attribute__((aligned(64))) BarrierSlot;
+
+/**
+ * kind: BARRIER_PTHREAD or BARRIER_SPIN
+ * count: Threads still to arrive at the current crossing
+ * sense: Flipped by the last thread of each crossing, also the futex word
+ * sleepers: Threads sleeping on the futex
+ */
+typedef struct {
+
+    BarrierKind kind;
+    int numberOfThreads;
+    pthread_barrier_t pthreadBarrier;
+    int count __attribute__((aligned(64)));
+    int sense __attribute__((aligned(64)));
+    int sleepers;
+    BarrierSlot *slots;
+
+} Barrier;
+
+/**
+ * Initialize the barrier for numberOfThreads threads. BARRIER_AUTO spins
+ * when every thread can have its own CPU and sleeps otherwise
+ */
+void barrierInit(Barrier *barrier, int numberOfThreads, BarrierKind kind);
+
+/**
+ * Wait until numberOfThreads threads arrive. thread is the index of the
+ * caller in [0, numberOfThreads). Like pthread_barrier_wait, exactly one
+ * thread gets PTHREAD_BARRIER_SERIAL_THREAD and the others 0
+ */
+int barrierWait(Barrier *barrier, int thread);
+
+/**
+ * Clear the wait time of every thread
+ */
+void barrierResetWait(Barrier *barrier);
+
+/**
+ * Name of the kind in use, "pthread" or "spin"
+ */
+const char* barrierName(const Barrier *barrier);
+
+void barrierDestroy(Barrier *barrier);
+
+#endif
@@ -0,0 +1,150 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "bench.h"
+
+static const char *methodNames[] = { "jacobi", "gauss-seidel", "sor", "chebyshev" };
+static const char *precisionNames[] = { "double", "mixed", "check" };
+
+static int compareTimes(const void *a, const void *b){
+
+    double x = *(const double*) a;
+    double y = *(const double*) b;
+
+    return (x > y) - (x < y);
+}
+
+/**
+ * Value below which a fraction p of the sorted times fall
+ */
+static double percentile(const double *times, int count, double p){
+
+    double position = p * (count - 1);
+    int below = (int) position;
+
+    if(below >= count - 1)
+        return times[count - 1];
+
+    return times[below] + (position - below) * (times[below + 1] - times[below]);
+}
+
+void computeStatistics(double *times, int count, const JrResult *result, Statistics *statistics){
+
+    int i;
+    double sum = 0;
+    double squares = 0;
+
+    qsort(times, count, sizeof(double), compareTimes);
+
+    for(i = 0; i < count; i++)
+        sum = sum + times[i];
+
+    statistics->runs = count;
+    statistics->mean = sum / count;
+
+    for(i = 0; i < count; i++)
+        squares = squares + (times[i] - statistics->mean) * (times[i] - statistics->mean);
+
+    statistics->stddev = count > 1 ? sqrt(squares / (count - 1)) : 0;
+    statistics->min = times[0];
+    statistics->median = percentile(times, count, 0.5);
+    statistics->p90 = percentile(times, count, 0.9);
+    statistics->p99 = percentile(times, count, 0.99);
+
+    statistics->gflops = 0;
+    statistics->bandwidth = 0;
+    if(statistics->median > 0){
+        statistics->gflops = result->flops / statistics->median / 1e9;
+        statistics->bandwidth = result->bytes / statistics->median / 1e9;
+    }
+}
+
+/**
+ * Write s as a JSON string, control characters as \u00XX
+ */
+static void writeJsonString(FILE *file, const char *s){
+
+    fputc('"', file);
+    for(; *s != '\0'; s++){
+        if((unsigned char) *s < 0x20){
+            fprintf(file, "\\u%04x", (unsigned char) *s);
+            continue;
+        }
+        if(*s == '"' || *s == '\\')
+            fputc('\\', file);
+        fputc(*s, file);
+    }
+    fputc('"', file);
+}
+
+/**
+ * Write s as a quoted CSV field, quotes doubled
+ */
+static void writeCsvString(FILE *file, const char *s){
+
+    fputc('"', file);
+    for(; *s != '\0'; s++){
+        if(*s == '"')
+            fputc('"', file);
+        fputc(*s, file);
+    }
+    fputc('"', file);
+}
+
+int appendJson(const char *path, const Options *options, const JrResult *result,
+        const Statistics *statistics){
+
+    FILE *file = fopen(path, "a");
+
+    if(file == NULL){
+        fprintf(stderr, "Could not open %s\n", path);
+        return 1;
+    }
+
+    fprintf(file, "{\"matrix\": ");
+    writeJsonString(file, options->matrixPath);
+    fprintf(file, ", \"order\": %d, \"engine\": \"%s\", \"kernel\": \"%s\", \"storage\": \"%s\"",
+            result->order, result->engine, result->kernel, result->storage);
+    fprintf(file, ", \"method\": \"%s\", \"async\": %s, \"precision\": \"%s\", \"threads\": %d",
+            methodNames[options->method], options->async ? "true" : "false",
+            precisionNames[options->precision], result->threads);
+    fprintf(file, ", \"iterations\": %d, \"warmup\": %d, \"runs\": %d",
+            result->iterations, options->warmup, statistics->runs);
+    fprintf(file, ", \"min\": %e, \"median\": %e, \"mean\": %e, \"stddev\": %e, \"p90\": %e, \"p99\": %e",
+            statistics->min, statistics->median, statistics->mean, statistics->stddev,
+            statistics->p90, statistics->p99);
+    fprintf(file, ", \"gflops\": %f, \"bandwidth\": %f}\n", statistics->gflops, statistics->bandwidth);
+
+    fclose(file);
+
+    return 0;
+}
+
+int appendCsv(const char *path, const Options *options, const JrResult *result,
+        const Statistics *statistics){
+
+    FILE *file = fopen(path, "a");
+
+    if(file == NULL){
+        fprintf(stderr, "Could not open %s\n", path);
+        return 1;
+    }
+
+    fseek(file, 0, SEEK_END);
+    if(ftell(file) == 0)
+        fprintf(file, "matrix,order,engine,kernel,storage,method,async,precision,threads,"
+                "iterations,warmup,runs,min,median,mean,stddev,p90,p99,gflops,bandwidth\n");
+
+    writeCsvString(file, options->matrixPath);
+    fprintf(file, ",%d,%s,%s,%s,%s,%d,%s,%d,%d,%d,%d,%e,%e,%e,%e,%e,%e,%f,%f\n",
+            result->order, result->engine, result->kernel, result->storage,
+            methodNames[options->method], options->async, precisionNames[options->precision],
+            result->threads, result->iterations, options->warmup, statistics->runs,
+            statistics->min, statistics->median, statistics->mean, statistics->stddev,
+            statistics->p90, statistics->p99, statistics->gflops, statistics->bandwidth);
+
+    fclose(file);
+
+    return 0;
+}
@@ -0,0 +1,50 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include "jacobi.h"
+
+/**
+ * Statistics of the timed solves of a run, and their machine-readable output
+ * (--json, --csv)
+ *
+ * min/median/mean/stddev/p90/p99: Of the solve times, in seconds. stddev is
+ * the sample standard deviation, the percentiles interpolate between the two
+ * closest solves
+ * gflops/bandwidth: GFLOP/s and GB/s of the median solve, from the flops and
+ * bytes of JrResult
+ */
+typedef struct {
+
+    int runs;
+    double min;
+    double median;
+    double mean;
+    double stddev;
+    double p90;
+    double p99;
+    double gflops;
+    double bandwidth;
+
+} Statistics;
+
+/**
+ * Compute the statistics of count solve times, sorting them. result is the
+ * last solve, every solve of a run does the same work
+ */
+void computeStatistics(double *times, int count, const JrResult *result, Statistics *statistics);
+
+/**
+ * Append a run to path, as a JSON object on a line of its own (JSON Lines).
+ * Returns 1 if the file can not be written
+ */
+int appendJson(const char *path, const Options *options, const JrResult *result,
+        const Statistics *statistics);
+
+/**
+ * Append a run to path as a CSV row, after a header if the file is empty.
+ * Returns 1 if the file can not be written
+ */
+int appendCsv(const char *path, const Options *options, const JrResult *result,
+        const Statistics *statistics);
+
+#endif
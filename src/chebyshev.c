@@ -0,0 +1,107 @@
+#include <stdlib.h>
+#include <math.h>
+
+#include "chebyshev.h"
+
+// Power iterations for each end of the spectrum
+#define SPECTRUM_ITERATIONS 100
+
+// Each end is moved out by this fraction of the width of the interval
+#define SPECTRUM_MARGIN 0.02
+
+// Largest high trusted, the recurrence needs high < 1
+#define SPECTRUM_MAX 0.9999
+
+/**
+ * y = (G - shift) x with G = -(L* + R*)
+ */
+static void multiply(const Kernel *kernel, const Blocking *blocking, const double *Ma, int lda,
+        const CsrMatrix *sparse, int order, double shift, const double *x, double *y){
+
+    int i;
+
+    if(sparse == NULL){
+        multiRowDot(kernel, blocking, Ma, lda, order, x, order, y);
+    }
+    else{
+        for(i = 0; i < order; i++){
+            y[i] = csrRowDot(sparse, i, x);
+        }
+    }
+
+    for(i = 0; i < order; i++){
+        y[i] = - y[i] - shift * x[i];
+    }
+}
+
+static double dot(const double *x, const double *y, int order){
+
+    int i;
+    double sum = 0;
+
+    for(i = 0; i < order; i++){
+        sum = sum + x[i] * y[i];
+    }
+
+    return sum;
+}
+
+/**
+ * Eigenvalue of G farthest from shift, by power iteration on G - shift
+ */
+static double farthestEigenvalue(const Kernel *kernel, const Blocking *blocking, const double *Ma,
+        int lda, const CsrMatrix *sparse, int order, double shift){
+
+    int i, k;
+    double *x = (double*) malloc(sizeof(double) * order);
+    double *y = (double*) malloc(sizeof(double) * order);
+    double *temp;
+    double length, rayleigh = 0;
+
+    // Uneven start, so it is unlikely to miss the dominant eigenvector
+    for(i = 0; i < order; i++){
+        x[i] = 1 + (double) (i % 7) / 7;
+    }
+
+    for(k = 0; k < SPECTRUM_ITERATIONS; k++){
+        length = sqrt(dot(x, x, order));
+        if(!(length > 0))
+            break;
+        for(i = 0; i < order; i++){
+            x[i] = x[i] / length;
+        }
+
+        multiply(kernel, blocking, Ma, lda, sparse, order, shift, x, y);
+        rayleigh = dot(x, y, order);
+
+        temp = x;
+        x = y;
+        y = temp;
+    }
+
+    free(x);
+    free(y);
+
+    return rayleigh + shift;
+}
+
+void estimateSpectrum(const Kernel *kernel, const Blocking *blocking, const double *Ma,
+        int lda, const CsrMatrix *sparse, int order, Spectrum *spectrum){
+
+    double first, second, width;
+
+    first = farthestEigenvalue(kernel, blocking, Ma, lda, sparse, order, 0);
+    second = farthestEigenvalue(kernel, blocking, Ma, lda, sparse, order, first);
+
+    spectrum->low = fmin(first, second);
+    spectrum->high = fmax(first, second);
+
+    width = spectrum->high - spectrum->low;
+    spectrum->low = spectrum->low - SPECTRUM_MARGIN * width;
+    spectrum->high = spectrum->high + SPECTRUM_MARGIN * width;
+    if(!(spectrum->high < SPECTRUM_MAX))
+        spectrum->high = SPECTRUM_MAX;
+
+    spectrum->gamma = 2 / (2 - spectrum->low - spectrum->high);
+    spectrum->rho = (spectrum->high - spectrum->low) / (2 - spectrum->low - spectrum->high);
+}
@@ -0,0 +1,87 @@
+#ifndef CHEBYSHEV_H
+#define CHEBYSHEV_H
+
+#include "kernels.h"
+#include "sparse.h"
+
+/**
+ * Chebyshev semi-iterative acceleration of Jacobi-Richardson
+ *
+ * prepareMatrices turns the system into x = G x + b* with G = -(L* + R*).
+ * When the eigenvalues of G lie in [low, high] with high < 1, the sweep is
+ * first extrapolated so they land in [-rho, rho]:
+ *
+ *   gamma = 2 / (2 - low - high)      rho = (high - low) / (2 - low - high)
+ *   y[i]  = gamma * (b*[i] - sum(A[i][j] * x_k[j])) + (1 - gamma) * x_k[i]
+ *
+ * and the Chebyshev recurrence combines it with the iterate before:
+ *
+ *   x_k+1[i] = omega_k+1 * (y[i] - x_k-1[i]) + x_k-1[i]
+ *
+ * with omega_1 = 1, omega_2 = 1 / (1 - rho^2 / 2) and
+ * omega_k+1 = 1 / (1 - rho^2 * omega_k / 4). Plain Jacobi converges like
+ * max(|low|, |high|)^k, this like about rho^(k/2) with rho smaller as soon as
+ * the spectrum is lopsided. Each row only reads its own values of x_k and
+ * x_k-1, so the update is the Jacobi sweep plus one more vector and the
+ * threads split it exactly like Jacobi-Richardson; omega is computed once
+ * per iteration by whoever swaps x.
+ *
+ * low and high are estimated with power iterations before the first solve:
+ * one on G for its dominant eigenvalue, one on G shifted by it for the other
+ * end. It assumes real eigenvalues (G symmetric or close to it). The power
+ * iteration approaches each end from inside, and an interval too narrow
+ * can make the recurrence diverge, so both ends are widened a little.
+ */
+
+/**
+ * Eigenvalues of G and the recurrence parameters derived from them
+ * low/high: Estimated interval of the eigenvalues, widened
+ * gamma: Extrapolation of the sweep
+ * rho: Spectral radius of the extrapolated iteration
+ */
+typedef struct {
+
+    double low;
+    double high;
+    double gamma;
+    double rho;
+
+} Spectrum;
+
+/**
+ * Estimate the spectrum of G = -(L* + R*) for the prepared dense (Ma) or
+ * sparse Matrix A. high is kept below 1 even if Jacobi diverges
+ */
+void estimateSpectrum(const Kernel *kernel, const Blocking *blocking, const double *Ma,
+        int lda, const CsrMatrix *sparse, int order, Spectrum *spectrum);
+
+/**
+ * omega of the next iteration once `iterations` iterations are done, omega
+ * is the one of the last iteration
+ */
+static inline double chebyshevWeight(const Spectrum *spectrum, int iterations, double omega){
+
+    double rho = spectrum->rho;
+
+    if(iterations == 0)
+        return 1;
+
+    if(iterations == 1)
+        return 1 / (1 - rho * rho / 2);
+
+    return 1 / (1 - rho * rho * omega / 4);
+}
+
+/**
+ * New value of a row from its Jacobi sweep value and its values in the last
+ * two iterates
+ */
+static inline double chebyshevRow(const Spectrum *spectrum, double omega, double sweep,
+        double current, double previous){
+
+    double extrapolated = spectrum->gamma * sweep + (1 - spectrum->gamma) * current;
+
+    return omega * (extrapolated - previous) + previous;
+}
+
+#endif
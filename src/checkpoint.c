@@ -0,0 +1,252 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "checkpoint.h"
+#include "solver.h"
+
+/**
+ * Checkpoint read with --resume, before the first solve overwrites the file
+ * resumeRead: The file was read, or there was none
+ * resumeIteration: Its iteration, 0 without one
+ * resumeStart/resumeHistory: Its iterate and the errors of its iterations
+ */
+static int resumeRead;
+static int resumeIteration;
+static double *resumeStart;
+static double *resumeHistory;
+
+/**
+ * Save the snapshot to the temporary file and rename it over the checkpoint
+ */
+static int writeCheckpoint(Checkpoint *checkpoint){
+
+    FILE *file;
+    int order = checkpoint->header.order;
+    int iteration = checkpoint->header.iteration;
+    int failed;
+
+    file = fopen(checkpoint->temporary, "wb");
+    if(file == NULL)
+        return 1;
+
+    failed = fwrite(&checkpoint->header, sizeof(CheckpointHeader), 1, file) != 1
+        || fwrite(checkpoint->snapshot, sizeof(double), order, file) != (size_t) order
+        || fwrite(checkpoint->history, sizeof(double), iteration, file) != (size_t) iteration
+        || fflush(file) != 0 || fsync(fileno(file)) != 0;
+
+    if(fclose(file) != 0 || failed)
+        return 1;
+
+    return rename(checkpoint->temporary, checkpoint->path) != 0;
+}
+
+/**
+ * Writer thread, saves every snapshot handed over until checkpointEnd
+ */
+static void* writeCheckpoints(void *rawCheckpoint){
+
+    Checkpoint *checkpoint = (Checkpoint*) rawCheckpoint;
+    struct timespec start, finish;
+
+    pthread_mutex_lock(&checkpoint->mutex);
+    while(1){
+        while(!checkpoint->pending && !checkpoint->stop)
+            pthread_cond_wait(&checkpoint->changed, &checkpoint->mutex);
+
+        if(!checkpoint->pending)
+            break;
+        pthread_mutex_unlock(&checkpoint->mutex);
+
+        // The solve goes on without a checkpoint if it can not be written
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        if(writeCheckpoint(checkpoint) != 0)
+            perror("Checkpoint");
+        clock_gettime(CLOCK_MONOTONIC, &finish);
+
+        pthread_mutex_lock(&checkpoint->mutex);
+        checkpoint->writeTime = checkpoint->writeTime + elapsedTime(start, finish);
+        checkpoint->written++;
+        checkpoint->pending = 0;
+        pthread_cond_broadcast(&checkpoint->changed);
+    }
+    pthread_mutex_unlock(&checkpoint->mutex);
+
+    return NULL;
+}
+
+/**
+ * Read the iterate and errors of the checkpoint file into resumeStart and
+ * resumeHistory, if there is one
+ */
+static int readCheckpoint(Checkpoint *checkpoint){
+
+    FILE *file;
+    CheckpointHeader header;
+    int order = checkpoint->header.order;
+
+    file = fopen(checkpoint->path, "rb");
+    if(file == NULL){
+        fprintf(outputFile, "Checkpoint: nothing to resume in %s, starting from x = 0\n", checkpoint->path);
+        resumeRead = 1;
+        return 0;
+    }
+
+    if(fread(&header, sizeof(header), 1, file) != 1
+            || memcmp(header.magic, JRCKPT_MAGIC, sizeof(header.magic)) != 0
+            || header.version != JRCKPT_VERSION){
+        fprintf(stderr, "%s is not a checkpoint\n", checkpoint->path);
+        fclose(file);
+        return 1;
+    }
+
+    if(header.order != order || header.rowTest != checkpoint->header.rowTest
+            || header.error != checkpoint->header.error || header.testedB != checkpoint->header.testedB
+            || header.iteration < 0 || header.iteration >= checkpoint->iteMax){
+        fprintf(stderr, "The checkpoint %s belongs to another problem\n", checkpoint->path);
+        fclose(file);
+        return 1;
+    }
+
+    if(header.precision != checkpoint->header.precision || header.method != checkpoint->header.method){
+        fprintf(stderr, "The checkpoint %s was written with another --precision or --method\n", checkpoint->path);
+        fclose(file);
+        return 1;
+    }
+
+    resumeStart = (double*) malloc(sizeof(double) * order);
+    resumeHistory = (double*) malloc(sizeof(double) * checkpoint->iteMax);
+    if(fread(resumeStart, sizeof(double), order, file) != (size_t) order
+            || fread(resumeHistory, sizeof(double), header.iteration, file) != (size_t) header.iteration){
+        fprintf(stderr, "The checkpoint %s is truncated\n", checkpoint->path);
+        fclose(file);
+        checkpointShutdown();
+        return 1;
+    }
+
+    fclose(file);
+    resumeRead = 1;
+    resumeIteration = header.iteration;
+
+    return 0;
+}
+
+int openCheckpoint(JrProblem *problem){
+
+    Checkpoint *checkpoint = (Checkpoint*) calloc(1, sizeof(Checkpoint));
+    size_t length = strlen(options.checkpointPath);
+
+    memcpy(checkpoint->header.magic, JRCKPT_MAGIC, sizeof(checkpoint->header.magic));
+    checkpoint->header.version = JRCKPT_VERSION;
+    checkpoint->header.order = problem->J_ORDER;
+    checkpoint->header.rowTest = problem->J_ROW_TEST;
+    checkpoint->header.error = problem->J_ERROR;
+    checkpoint->header.testedB = problem->testedB[0];
+    checkpoint->header.precision = options.precision;
+    checkpoint->header.method = options.method;
+
+    checkpoint->path = strdup(options.checkpointPath);
+    checkpoint->temporary = (char*) malloc(length + sizeof(".tmp"));
+    snprintf(checkpoint->temporary, length + sizeof(".tmp"), "%s.tmp", options.checkpointPath);
+    checkpoint->every = options.checkpointEvery;
+    checkpoint->iteMax = problem->J_ITE_MAX;
+
+    checkpoint->start = (double*) calloc(problem->J_ORDER, sizeof(double));
+    checkpoint->snapshot = (double*) malloc(sizeof(double) * problem->J_ORDER);
+    checkpoint->history = (double*) malloc(sizeof(double) * problem->J_ITE_MAX);
+
+    pthread_mutex_init(&checkpoint->mutex, NULL);
+    pthread_cond_init(&checkpoint->changed, NULL);
+
+    problem->checkpoint = checkpoint;
+
+    if(!options.resume)
+        return 0;
+
+    if(!resumeRead && readCheckpoint(checkpoint) != 0)
+        return 1;
+
+    checkpoint->resumed = resumeIteration;
+    if(resumeIteration > 0){
+        memcpy(checkpoint->start, resumeStart, sizeof(double) * problem->J_ORDER);
+        memcpy(checkpoint->history, resumeHistory, sizeof(double) * resumeIteration);
+    }
+
+    return 0;
+}
+
+int checkpointBegin(Checkpoint *checkpoint, double *x){
+
+    // Without a checkpoint x keeps the starting point of the solve
+    if(checkpoint->resumed > 0)
+        memcpy(x, checkpoint->start, sizeof(double) * checkpoint->header.order);
+
+    checkpoint->pending = 0;
+    checkpoint->stop = 0;
+    checkpoint->written = 0;
+    checkpoint->skipped = 0;
+    checkpoint->writeTime = 0;
+
+    pthread_create(&checkpoint->writer, NULL, &writeCheckpoints, checkpoint);
+
+    return checkpoint->resumed;
+}
+
+void checkpointIteration(Checkpoint *checkpoint, const double *x, int iteration, double error){
+
+    checkpoint->history[iteration - 1] = error;
+
+    // The last iteration is not saved, a resumed solve always has one to do
+    if(iteration % checkpoint->every != 0 || error <= checkpoint->header.error
+            || iteration >= checkpoint->iteMax)
+        return;
+
+    // Only a copy of x, the writer does the I/O
+    pthread_mutex_lock(&checkpoint->mutex);
+    if(checkpoint->pending){
+        checkpoint->skipped++;
+    }
+    else{
+        memcpy(checkpoint->snapshot, x, sizeof(double) * checkpoint->header.order);
+        checkpoint->header.iteration = iteration;
+        checkpoint->pending = 1;
+        pthread_cond_broadcast(&checkpoint->changed);
+    }
+    pthread_mutex_unlock(&checkpoint->mutex);
+}
+
+void checkpointEnd(Checkpoint *checkpoint){
+
+    pthread_mutex_lock(&checkpoint->mutex);
+    checkpoint->stop = 1;
+    pthread_cond_broadcast(&checkpoint->changed);
+    pthread_mutex_unlock(&checkpoint->mutex);
+
+    pthread_join(checkpoint->writer, NULL);
+
+    fprintf(outputFile, "Checkpoint: resumed from iteration %d, %d written in %lf s, %d skipped\n",
+            checkpoint->resumed, checkpoint->written, checkpoint->writeTime, checkpoint->skipped);
+}
+
+void checkpointClose(Checkpoint *checkpoint){
+
+    pthread_mutex_destroy(&checkpoint->mutex);
+    pthread_cond_destroy(&checkpoint->changed);
+    free(checkpoint->path);
+    free(checkpoint->temporary);
+    free(checkpoint->start);
+    free(checkpoint->snapshot);
+    free(checkpoint->history);
+}
+
+void checkpointShutdown(void){
+
+    free(resumeStart);
+    free(resumeHistory);
+    resumeStart = NULL;
+    resumeHistory = NULL;
+    resumeIteration = 0;
+    resumeRead = 0;
+}
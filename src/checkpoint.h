@@ -0,0 +1,129 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <stdint.h>
+#include <pthread.h>
+
+#include "jacobi.h"
+
+/**
+ * Checkpoint and restart of a Jacobi-Richardson solve (--checkpoint,
+ * --resume)
+ *
+ * Every checkpointEvery iterations the thread that swaps x copies the new
+ * iterate into a snapshot and hands it to a writer thread, which saves it
+ * with the iteration count and the error of every iteration so far:
+ *
+ *   [CheckpointHeader][x, order doubles][error of iterations 1..iteration]
+ *
+ * The sweep never waits for the disk: if the writer is still busy with the
+ * previous snapshot, that checkpoint is skipped. The file is written to
+ * path.tmp and renamed over the old one, so a crash while writing leaves the
+ * previous checkpoint intact.
+ *
+ * Jacobi-Richardson only depends on the previous iterate, so a solve resumed
+ * from iteration k goes through the same iterates, errors and iteration count
+ * as the one that wrote the checkpoint.
+ */
+
+#define JRCKPT_MAGIC "JRCHKPNT"
+#define JRCKPT_VERSION 2
+
+/**
+ * The problem is identified by its order, tested row, J_ERROR and the
+ * original value of Array B at the tested row, and the solve by its
+ * --precision and --method. A checkpoint of another problem or solve is
+ * rejected
+ */
+typedef struct {
+
+    char magic[8];
+    uint32_t version;
+    int32_t order;
+    int32_t rowTest;
+    int32_t iteration;
+    int32_t precision;
+    int32_t method;
+    double error;
+    double testedB;
+
+} CheckpointHeader;
+
+/**
+ * Checkpoints of a problem
+ *
+ * header: Identity of the problem, iteration is the one of the snapshot
+ * path/temporary: --checkpoint file and the file written before the rename
+ * every: Iterations between two checkpoints
+ * iteMax: J_ITE_MAX of the problem
+ * resumed: Iteration of the checkpoint read with --resume, 0 starts from
+ * the usual starting point
+ * start: Iterate of the checkpoint read, the same for every load
+ * history: Error of every iteration, J_ITE_MAX entries
+ * snapshot: Iterate handed to the writer
+ * pending: A snapshot is waiting for or being written by the writer
+ * stop: Set by checkpointEnd, the writer quits
+ * written/skipped: Checkpoints saved and skipped during the current solve
+ * writeTime: Time the writer spent saving them
+ */
+typedef struct {
+
+    CheckpointHeader header;
+    char *path;
+    char *temporary;
+    int every;
+    int iteMax;
+    int resumed;
+    double *start;
+    double *history;
+    double *snapshot;
+    int pending;
+    int stop;
+    pthread_t writer;
+    pthread_mutex_t mutex;
+    pthread_cond_t changed;
+    int written;
+    int skipped;
+    double writeTime;
+
+} Checkpoint;
+
+/**
+ * Checkpoints of a loaded problem to options.checkpointPath, with the
+ * iterate to resume from with options.resume. The file is only read for the
+ * first problem, the solves overwrite it and every load after that resumes
+ * from what the first one read. Returns 0 on success, 1 if the checkpoint
+ * can not be read or belongs to another problem
+ */
+int openCheckpoint(JrProblem *problem);
+
+/**
+ * Start the writer for a solve and copy the iterate to resume from, if
+ * any, into x. Returns the iteration the solve continues from
+ */
+int checkpointBegin(Checkpoint *checkpoint, double *x);
+
+/**
+ * Record the error of an iteration and, every checkpointEvery iterations,
+ * hand x to the writer. Called by a single thread after the swap
+ */
+void checkpointIteration(Checkpoint *checkpoint, const double *x, int iteration, double error);
+
+/**
+ * Wait for the snapshot being written, stop the writer and report the
+ * checkpoints of the solve
+ */
+void checkpointEnd(Checkpoint *checkpoint);
+
+/**
+ * Free everything created by openCheckpoint
+ */
+void checkpointClose(Checkpoint *checkpoint);
+
+/**
+ * Forget the checkpoint read with --resume, the next openCheckpoint reads
+ * the file again
+ */
+void checkpointShutdown(void);
+
+#endif
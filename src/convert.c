@@ -0,0 +1,119 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "matrixio.h"
+
+/**
+ * Converts a matrix from the text format used in matrices/ to the binary
+ * container described in matrixio.h
+ *
+ * By default the matrix is stored already prepared (divided by the main
+ * diagonal), so the solvers can iterate on the mapped file without touching
+ * it. Use --raw to store A and b exactly as they are in the text file.
+ *
+ * The text file is streamed one row at a time, only O(J_ORDER) memory is
+ * required, so it also works for matrices that would not fit in memory.
+ */
+int main(int argc, char* argv[]){
+
+    int i, j;
+    int order, rowTest, iteMax;
+    double error;
+    int prepared = 1;
+    BinaryHeader header;
+
+    if(argc < 3){
+        printf("Invalid number of arguments: ./convert matrix.txt matrix.bin [--raw]\n");
+        return 1;
+    }
+
+    if(argc > 3 && strcmp(argv[3], "--raw") == 0)
+        prepared = 0;
+
+    FILE *input = fopen(argv[1], "r");
+    if(input == NULL){
+        perror(argv[1]);
+        return 1;
+    }
+
+    if(fscanf(input, "%d%d%lf%d", &order, &rowTest, &error, &iteMax) != 4 ||
+            order <= 0 || rowTest < 0 || rowTest >= order){
+        fprintf(stderr, "%s: invalid header\n", argv[1]);
+        fclose(input);
+        return 1;
+    }
+
+    FILE *output = fopen(argv[2], "wb");
+    if(output == NULL){
+        perror(argv[2]);
+        fclose(input);
+        return 1;
+    }
+
+    layoutBinaryHeader(&header, order, rowTest, error, iteMax,
+            prepared ? JRBIN_PREPARED : 0);
+
+    double *row = (double*) malloc(sizeof(double) * order);
+    double *testedRow = (double*) malloc(sizeof(double) * order);
+    double *diagonal = (double*) malloc(sizeof(double) * order);
+
+    // The header is written again at the end, once testedB is known
+    writeBinaryHeader(output, &header);
+
+    for(i = 0; i < order; i++){
+        for(j = 0; j < order; j++){
+            if(fscanf(input, "%lf", &row[j]) != 1){
+                fprintf(stderr, "%s: unexpected end of Matrix A\n", argv[1]);
+                return 1;
+            }
+        }
+
+        if(i == rowTest)
+            memcpy(testedRow, row, sizeof(double) * order);
+
+        diagonal[i] = row[i];
+        if(prepared){
+            for(j = 0; j < order; j++){
+                row[j] = row[j] / diagonal[i];
+            }
+            row[i] = 0;
+        }
+
+        writeBinaryVector(output, &header, row);
+    }
+
+    // Array B
+    for(i = 0; i < order; i++){
+        if(fscanf(input, "%lf", &row[i]) != 1){
+            fprintf(stderr, "%s: unexpected end of Array B\n", argv[1]);
+            return 1;
+        }
+    }
+
+    header.testedB = row[rowTest];
+    if(prepared){
+        for(i = 0; i < order; i++){
+            row[i] = row[i] / diagonal[i];
+        }
+    }
+    writeBinaryVector(output, &header, row);
+
+    if(prepared)
+        writeBinaryVector(output, &header, testedRow);
+
+    rewind(output);
+    writeBinaryHeader(output, &header);
+
+    if(ferror(output) || fclose(output) != 0){
+        fprintf(stderr, "%s: write failed\n", argv[2]);
+        return 1;
+    }
+
+    fclose(input);
+    free(row);
+    free(testedRow);
+    free(diagonal);
+
+    return 0;
+}
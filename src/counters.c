@@ -0,0 +1,189 @@
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#include "counters.h"
+
+// Bytes brought in by an LLC miss
+#define LINE_BYTES 64
+
+/**
+ * Event read by perf_event_open
+ */
+typedef struct {
+    const char *name;
+    uint32_t type;
+    uint64_t config;
+} CounterEvent;
+
+enum { CYCLES, INSTRUCTIONS, LLC_REFERENCES, LLC_MISSES, DTLB_MISSES, TASK_CLOCK, PAGE_FAULTS };
+
+static const CounterEvent events[COUNTERS] = {
+    { "cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    { "instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    { "llc-references", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_REFERENCES },
+    { "llc-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+    { "dtlb-misses", PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB |
+        (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+    { "task-clock", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK },
+    { "page-faults", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS }
+};
+
+// Why the cycles counter could not be opened, 0 if it could
+static int cyclesError;
+
+/**
+ * Counter of the calling thread on any CPU, user space only so it works with
+ * perf_event_paranoid up to 2
+ */
+static int openEvent(const CounterEvent *event){
+
+    struct perf_event_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = event->type;
+    attr.config = event->config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    return (int) syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+void countersInit(CounterSlot *slots, int count){
+
+    int t, e;
+
+    for(t = 0; t < count; t++){
+        slots[t].opened = 0;
+        for(e = 0; e < COUNTERS; e++){
+            slots[t].fd[e] = -1;
+            slots[t].values[e] = 0;
+        }
+    }
+}
+
+void countersBegin(CounterSlot *slot){
+
+    int e;
+
+    if(!slot->opened){
+        for(e = 0; e < COUNTERS; e++){
+            slot->fd[e] = openEvent(&events[e]);
+            if(e == CYCLES && slot->fd[e] < 0)
+                cyclesError = errno;
+        }
+        slot->opened = 1;
+    }
+
+    for(e = 0; e < COUNTERS; e++){
+        if(slot->fd[e] >= 0){
+            ioctl(slot->fd[e], PERF_EVENT_IOC_RESET, 0);
+            ioctl(slot->fd[e], PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+}
+
+void countersEnd(CounterSlot *slot){
+
+    int e;
+    uint64_t reading[3];
+
+    for(e = 0; e < COUNTERS; e++){
+        slot->values[e] = 0;
+        if(slot->fd[e] < 0)
+            continue;
+
+        ioctl(slot->fd[e], PERF_EVENT_IOC_DISABLE, 0);
+
+        // value, time enabled and time running
+        if(read(slot->fd[e], reading, sizeof(reading)) != sizeof(reading) || reading[2] == 0)
+            continue;
+
+        slot->values[e] = (double) reading[0] * reading[1] / reading[2];
+    }
+}
+
+void countersClose(CounterSlot *slots, int count){
+
+    int t, e;
+
+    for(t = 0; t < count; t++){
+        for(e = 0; e < COUNTERS; e++){
+            if(slots[t].fd[e] >= 0)
+                close(slots[t].fd[e]);
+            slots[t].fd[e] = -1;
+        }
+        slots[t].opened = 0;
+    }
+}
+
+/**
+ * Write the events available on every thread
+ */
+static void printValues(const char *label, const double *values, const int *available){
+
+    int e;
+
+    fprintf(outputFile, "%s:", label);
+    for(e = 0; e < COUNTERS; e++){
+        if(!available[e])
+            continue;
+
+        if(e == TASK_CLOCK)
+            fprintf(outputFile, " %s %lf s", events[e].name, values[e] / 1e9);
+        else
+            fprintf(outputFile, " %s %.0lf", events[e].name, values[e]);
+    }
+    fprintf(outputFile, "\n");
+}
+
+void printCounters(const CounterSlot *slots, int count, Data *data){
+
+    int t, e;
+    int available[COUNTERS];
+    double total[COUNTERS];
+    double flops, bytes;
+    char label[32];
+
+    for(e = 0; e < COUNTERS; e++){
+        available[e] = 1;
+        total[e] = 0;
+        for(t = 0; t < count; t++){
+            available[e] = available[e] && slots[t].fd[e] >= 0;
+            total[e] = total[e] + slots[t].values[e];
+        }
+    }
+
+    if(!available[CYCLES])
+        fprintf(outputFile, "Counters: hardware events unavailable (%s)\n", strerror(cyclesError));
+
+    printValues("Counters", total, available);
+    if(count > 1){
+        for(t = 0; t < count; t++){
+            snprintf(label, sizeof(label), "Counters thread %d", t);
+            printValues(label, slots[t].values, available);
+        }
+    }
+
+    if(!available[CYCLES] || !available[INSTRUCTIONS] || total[CYCLES] == 0)
+        return;
+
+    sweepCost(data, &flops, &bytes);
+    flops = flops * iterations;
+
+    fprintf(outputFile, "Counters: IPC %.2lf", total[INSTRUCTIONS] / total[CYCLES]);
+    if(available[LLC_REFERENCES] && available[LLC_MISSES] && total[LLC_REFERENCES] > 0)
+        fprintf(outputFile, ", LLC miss rate %.2lf%%", 100 * total[LLC_MISSES] / total[LLC_REFERENCES]);
+    if(available[LLC_MISSES] && flops > 0)
+        fprintf(outputFile, ", LLC bytes/flop %.4lf", total[LLC_MISSES] * LINE_BYTES / flops);
+    if(available[DTLB_MISSES] && total[INSTRUCTIONS] > 0)
+        fprintf(outputFile, ", dTLB misses/kinstr %.4lf", 1000 * total[DTLB_MISSES] / total[INSTRUCTIONS]);
+    fprintf(outputFile, "\n");
+}
@@ -0,0 +1,67 @@
+#ifndef COUNTERS_H
+#define COUNTERS_H
+
+#include <stdint.h>
+
+#include "solver.h"
+
+/**
+ * Performance counters of the solver threads (--counters), read with
+ * perf_event_open
+ *
+ * Every thread opens its own counters the first time it solves and keeps
+ * them until its engine stops, so each solve only resets, enables and reads
+ * them around the iteration loop. Each event is opened on its own: the ones
+ * the kernel, the CPU or perf_event_paranoid do not allow (typically every
+ * hardware event in a virtual machine) are left out and the rest are still
+ * reported. Counts are scaled by the time the event was scheduled when the
+ * PMU multiplexes them.
+ *
+ * After each solve the output file gets the sum over the threads, one line
+ * per thread and metrics derived from them: instructions per cycle, LLC
+ * miss rate, LLC traffic per flop (misses of 64 bytes over the flops of
+ * sweepCost) and dTLB misses per thousand instructions.
+ */
+
+// Events read, see events in counters.c
+#define COUNTERS 7
+
+/**
+ * Counters of a thread, one or more cache lines each
+ * fd: File descriptor of each event, -1 if it could not be opened
+ * opened: The thread already tried to open them
+ * values: Scaled counts of the last solve
+ */
+typedef struct {
+    int fd[COUNTERS];
+    int opened;
+    double values[COUNTERS];
+} __attribute__((aligned(64))) CounterSlot;
+
+/**
+ * Mark count slots as not opened yet
+ */
+void countersInit(CounterSlot *slots, int count);
+
+/**
+ * Open the counters of the calling thread if needed, then reset and enable
+ * them
+ */
+void countersBegin(CounterSlot *slot);
+
+/**
+ * Disable the counters of the calling thread and read them into values
+ */
+void countersEnd(CounterSlot *slot);
+
+/**
+ * Close the counters of count slots
+ */
+void countersClose(CounterSlot *slots, int count);
+
+/**
+ * Write the counters of the last solve of data to the output file
+ */
+void printCounters(const CounterSlot *slots, int count, Data *data);
+
+#endif
@@ -0,0 +1,147 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "frontend.h"
+#include "jacobi.h"
+#include "bench.h"
+
+/**
+ * Solve the problem again from x = 0 and report the iterations the initial
+ * guess saved
+ */
+static void compareColdStart(JrProblem *problem, const JrResult *warm, FILE *outputFile){
+
+    JrResult cold;
+    int saved;
+
+    fprintf(outputFile, "\nCold start from x = 0, for comparison\n");
+    jrSetInitial(problem, NULL);
+    jrSolve(problem, &cold);
+
+    saved = cold.iterations - warm->iterations;
+    fprintf(outputFile, "Warm start: %d iterations instead of %d, %d saved (%.1lf%%)\n",
+            warm->iterations, cold.iterations, saved, cold.iterations > 0 ? 100.0 * saved / cold.iterations : 0);
+    printf("Warm start: %d iterations instead of %d, %d saved\n", warm->iterations, cold.iterations, saved);
+}
+
+int runSolver(int argc, char *argv[], int needsThreads, int defaultRuns, EngineKind engine){
+
+    int i, solves;
+    struct timespec start, loaded, prepared, tuned;
+    double loadTime = 0;
+    double prepareTime = 0;
+    double tuneTime = 0;
+    double average = 0;
+    int loads = 0;
+    int failed = 0;
+    double *times;
+    Options options;
+    JrProblem *problem = NULL;
+    JrResult result;
+    Statistics statistics;
+    FILE *outputFile;
+
+    // if the user has not passed the file path as argument
+    if(parseOptions(argc, argv, needsThreads, defaultRuns, &options) != 0)
+        return 1;
+
+    if(options.engine == ENGINE_DEFAULT)
+        options.engine = engine;
+
+    outputFile = fopen(options.outputPath, "w");
+    if(outputFile == NULL){
+        fprintf(stderr, "Could not open %s\n", options.outputPath);
+        return 1;
+    }
+
+    if(jrInit(&options, outputFile) != 0)
+        return 1;
+
+    // The warmup solves come first and are left out of every average
+    solves = options.warmup + options.runs;
+    times = (double*) malloc(sizeof(double) * options.runs);
+
+    for(i = 0; i < solves; i++){
+
+        // Read data from file, only once when the matrix is reused
+        if(i == 0 || !options.loadOnce){
+            clock_gettime(CLOCK_MONOTONIC, &start);
+
+            problem = jrLoad(options.matrixPath);
+            if(problem == NULL)
+                return 1;
+
+            clock_gettime(CLOCK_MONOTONIC, &loaded);
+            if(jrPrepare(problem) != 0)
+                return 1;
+            if(options.initialPath != NULL && jrReadInitial(problem, options.initialPath) != 0)
+                return 1;
+            clock_gettime(CLOCK_MONOTONIC, &prepared);
+
+            loadTime = loadTime + elapsedTime(start, loaded);
+            prepareTime = prepareTime + elapsedTime(loaded, prepared);
+            loads++;
+
+            if(loads == 1)
+                jrDescribe(problem);
+
+            // Only the first load runs trials, later ones reuse the result
+            if(options.tune != TUNE_OFF){
+                jrTune(problem);
+                clock_gettime(CLOCK_MONOTONIC, &tuned);
+                tuneTime = tuneTime + elapsedTime(prepared, tuned);
+            }
+        }
+
+        failed = jrSolve(problem, &result) || failed;
+        if(i >= options.warmup){
+            times[i - options.warmup] = result.time;
+            average = average + result.time;
+        }
+
+        // The x of the last solve is the one exported
+        if(i == solves - 1){
+            if(options.exportPath != NULL && jrExportSolution(problem, options.exportPath) != 0)
+                failed = 1;
+            if(options.initialPath != NULL)
+                compareColdStart(problem, &result, outputFile);
+        }
+
+        // Free allocated memory
+        if(!options.loadOnce || i == solves - 1)
+            jrFreeProblem(problem);
+    }
+
+    computeStatistics(times, options.runs, &result, &statistics);
+    free(times);
+
+    fprintf(outputFile, "\nLoad Average: %lf\n", loadTime/loads);
+    fprintf(outputFile, "Preprocessing Average: %lf\n", prepareTime/loads);
+    if(options.tune != TUNE_OFF)
+        fprintf(outputFile, "Tuning: %lf\n", tuneTime);
+    fprintf(outputFile, "Average: %lf\n", average/options.runs);
+    fprintf(outputFile, "Min: %lf Median: %lf Stddev: %lf P90: %lf P99: %lf (%d runs, %d warmup)\n",
+            statistics.min, statistics.median, statistics.stddev, statistics.p90, statistics.p99,
+            options.runs, options.warmup);
+    fprintf(outputFile, "GFLOP/s: %lf Bandwidth: %lf GB/s\n", statistics.gflops, statistics.bandwidth);
+    printf("Number of Iterations: %d\n", result.iterations);
+    printf("Load Average: %lf\n", loadTime/loads);
+    printf("Preprocessing Average: %lf\n", prepareTime/loads);
+    if(options.tune != TUNE_OFF)
+        printf("Tuning: %lf\n", tuneTime);
+    printf("Time Average: %lf\n", average/options.runs);
+    printf("Time Median: %lf\n", statistics.median);
+    printf("Time Stddev: %lf\n", statistics.stddev);
+    printf("GFLOP/s: %lf\n", statistics.gflops);
+
+    if(options.jsonPath != NULL && appendJson(options.jsonPath, &options, &result, &statistics) != 0)
+        failed = 1;
+    if(options.csvPath != NULL && appendCsv(options.csvPath, &options, &result, &statistics) != 0)
+        failed = 1;
+
+    jrShutdown();
+    fclose(outputFile);
+
+    return failed;
+}
@@ -0,0 +1,22 @@
+#ifndef FRONTEND_H
+#define FRONTEND_H
+
+#include "options.h"
+
+/**
+ * Command line program over the solver library (see jacobi.h), shared by
+ * main, parallel and openmp
+ *
+ * Reads the options, loads and prepares the matrix (once with --load-once),
+ * solves it options.runs times and writes the load, preprocessing and solve
+ * averages to the output file and the standard output.
+ *
+ * needsThreads: THREADS_NUMBER is a required positional argument
+ * defaultRuns: Number of solves when --runs is not given
+ * engine: Engine used when --engine is not given
+ *
+ * Returns the exit status of the program
+ */
+int runSolver(int argc, char *argv[], int needsThreads, int defaultRuns, EngineKind engine);
+
+#endif
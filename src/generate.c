@@ -0,0 +1,114 @@
+#include <stdio.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Writes a sparse matrix in Matrix Market format: a 5-point stencil on a
+ * grid sqrt(J_ORDER) wide, with 5 on the main diagonal and -1 for each
+ * neighbor, so it is diagonally dominant
+ */
+int generateSparse(int order, FILE *output);
+
+/**
+ * Generates a test matrix in the text format used in matrices/
+ *
+ * Like the matrices already there, A has J_ORDER on the main diagonal and 1
+ * everywhere else (so it is diagonally dominant and Jacobi-Richardson
+ * converges), and B has random integer values between 0 and 99.
+ *
+ * When the output file ends with .mtx a sparse matrix is written instead,
+ * see generateSparse
+ */
+int main(int argc, char* argv[]){
+
+    int i, j;
+    int order;
+    unsigned int seed = 1;
+
+    if(argc < 3){
+        printf("Invalid number of arguments: ./generate ORDER output.txt [SEED]\n");
+        return 1;
+    }
+
+    order = atoi(argv[1]);
+    if(order <= 0){
+        fprintf(stderr, "Invalid order: %s\n", argv[1]);
+        return 1;
+    }
+
+    if(argc > 3)
+        seed = (unsigned int) atoi(argv[3]);
+    srand(seed);
+
+    FILE *output = fopen(argv[2], "w");
+    if(output == NULL){
+        perror(argv[2]);
+        return 1;
+    }
+
+    if(strlen(argv[2]) > 4 && strcmp(argv[2] + strlen(argv[2]) - 4, ".mtx") == 0){
+        generateSparse(order, output);
+        if(fclose(output) != 0){
+            perror(argv[2]);
+            return 1;
+        }
+        return 0;
+    }
+
+    // J_ORDER J_ROW_TEST J_ERROR J_ITE_MAX
+    fprintf(output, "%d\n%d\n%g\n%d\n", order, rand() % order, 0.001, 20000);
+
+    // Matrix A
+    for(i = 0; i < order; i++){
+        for(j = 0; j < order; j++){
+            fprintf(output, j == 0 ? "%d" : " %d", i == j ? order : 1);
+        }
+        fprintf(output, "\n");
+    }
+
+    // Array B
+    for(i = 0; i < order; i++){
+        fprintf(output, "%d\n", rand() % 100);
+    }
+
+    if(fclose(output) != 0){
+        perror(argv[2]);
+        return 1;
+    }
+
+    return 0;
+}
+
+int generateSparse(int order, FILE *output){
+
+    int i;
+    long long entries = 0;
+    int width = (int) sqrt((double) order);
+
+    if(width < 1)
+        width = 1;
+
+    // Lower triangle only: the diagonal, the left and the upper neighbors
+    for(i = 0; i < order; i++){
+        entries++;
+        if(i % width != 0)
+            entries++;
+        if(i >= width)
+            entries++;
+    }
+
+    fprintf(output, "%%%%MatrixMarket matrix coordinate real symmetric\n");
+    fprintf(output, "%% 5-point stencil, grid %d wide\n", width);
+    fprintf(output, "%d %d %lld\n", order, order, entries);
+
+    for(i = 0; i < order; i++){
+        fprintf(output, "%d %d 5\n", i + 1, i + 1);
+        if(i % width != 0)
+            fprintf(output, "%d %d -1\n", i + 1, i);
+        if(i >= width)
+            fprintf(output, "%d %d -1\n", i + 1, i + 1 - width);
+    }
+
+    return 0;
+}
@@ -0,0 +1,304 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+
+#include "solver.h"
+#include "tune.h"
+#include "trace.h"
+
+// Below this order a block of rows takes about as long to sweep as the two
+// barriers of an iteration, ENGINE_AUTO solves it on a single thread
+#define AUTO_SERIAL_ORDER 128
+
+// Engines linked in the library
+#define ENGINES 3
+
+Options options;
+FILE *outputFile;
+const Kernel *kernel;
+Blocking blocking;
+int iterations = 0;
+double rowTestResult = 0;
+double timeSpent = 0;
+
+// Every engine and whether it was started
+static const Engine *engines[ENGINES] = { &serialEngine, &pthreadEngine, &openmpEngine };
+static int started[ENGINES];
+
+/**
+ * Engine asked for by --engine, or the one ENGINE_AUTO picks for the order
+ */
+static const Engine* pickEngine(int order){
+
+    long threads = options.numberOfThreads;
+
+    switch(options.engine){
+        case ENGINE_SERIAL:
+            return &serialEngine;
+        case ENGINE_PTHREADS:
+            return &pthreadEngine;
+        case ENGINE_OPENMP:
+            return &openmpEngine;
+        default:
+            break;
+    }
+
+    // Only the pthreads engine has independent workers, and streams
+    if(options.async || options.outOfCore)
+        return &pthreadEngine;
+
+    if(threads == 0)
+        threads = sysconf(_SC_NPROCESSORS_ONLN);
+
+    if(threads <= 1 || order < AUTO_SERIAL_ORDER)
+        return &serialEngine;
+
+    return &pthreadEngine;
+}
+
+const Engine* useEngine(Data *data){
+
+    int e;
+    const Engine *engine = pickEngine(data->J_ORDER);
+
+    for(e = 0; engines[e] != engine; e++);
+
+    if(!started[e]){
+        fprintf(outputFile, "Engine: %s\n", engine->name);
+        loadTuning(data, engine);
+        engine->start();
+        started[e] = 1;
+    }
+
+    return engine;
+}
+
+int jrInit(const Options *initOptions, FILE *report){
+
+    options = *initOptions;
+    outputFile = report;
+
+    if(options.engine == ENGINE_DEFAULT)
+        options.engine = ENGINE_AUTO;
+
+    if(options.async && options.method != METHOD_JACOBI){
+        fprintf(stderr, "--async is only available for Jacobi-Richardson\n");
+        return 1;
+    }
+
+    if(options.async && options.engine != ENGINE_AUTO && options.engine != ENGINE_PTHREADS){
+        fprintf(stderr, "--async needs the pthreads engine\n");
+        return 1;
+    }
+
+    if(options.outOfCore && (options.method != METHOD_JACOBI || options.async ||
+                options.precision != PRECISION_DOUBLE || options.rhsPath != NULL)){
+        fprintf(stderr, "--out-of-core only solves Jacobi-Richardson in double with a single right-hand side\n");
+        return 1;
+    }
+
+    if(options.outOfCore && options.engine != ENGINE_AUTO && options.engine != ENGINE_PTHREADS){
+        fprintf(stderr, "--out-of-core needs the pthreads engine\n");
+        return 1;
+    }
+
+    if(options.checkpointPath != NULL && (options.method != METHOD_JACOBI || options.async
+                || options.rhsPath != NULL)){
+        fprintf(stderr, "--checkpoint only saves Jacobi-Richardson with a single right-hand side\n");
+        return 1;
+    }
+
+    if((options.initialPath != NULL || options.exportPath != NULL) && options.rhsPath != NULL){
+        fprintf(stderr, "--initial and --export only handle a single right-hand side\n");
+        return 1;
+    }
+
+    if(options.initialPath != NULL && options.resume){
+        fprintf(stderr, "--initial and --resume both set the starting point\n");
+        return 1;
+    }
+
+    if(options.resume && options.checkpointPath == NULL){
+        fprintf(stderr, "--resume needs the --checkpoint file to resume from\n");
+        return 1;
+    }
+
+    if(TRACE_OPEN() != 0)
+        return 1;
+
+    kernel = selectKernel();
+    fprintf(outputFile, "Kernel: %s\n", kernel->name);
+    detectBlocking(&blocking);
+    fprintf(outputFile, "Blocking: %d columns (L1 %ldK, L2 %ldK)\n", blocking.columns,
+            blocking.l1 / 1024, blocking.l2 / 1024);
+
+    return 0;
+}
+
+JrProblem* jrLoad(const char *path){
+
+    FILE *file;
+    Data *data;
+    int status;
+
+    file = fopen(path, "r");
+    if(file == NULL){
+        fprintf(stderr, "Could not open %s\n", path);
+        return NULL;
+    }
+
+    // Zeroed, so a matrix read halfway can be freed like a whole one. The
+    // file itself is no longer needed, text is parsed and binaries mapped
+    data = (Data*) calloc(1, sizeof(Data));
+    status = readFromFile(file, data);
+    fclose(file);
+
+    if(status != 0){
+        freeData(data);
+        return NULL;
+    }
+
+    return data;
+}
+
+int jrPrepare(JrProblem *problem){
+
+    prepareMatrices(problem);
+
+    if(options.method == METHOD_CHEBYSHEV){
+        if(prepareChebyshev(problem) != 0)
+            return 1;
+    }
+    else if(options.method != METHOD_JACOBI && prepareRelaxation(problem) != 0)
+        return 1;
+
+    if(options.precision != PRECISION_DOUBLE)
+        storeAsFloat(problem, options.precision == PRECISION_CHECK);
+
+    if(options.checkpointPath != NULL && openCheckpoint(problem) != 0)
+        return 1;
+
+    return 0;
+}
+
+void jrTune(JrProblem *problem){
+
+    tuneProblem(problem);
+}
+
+void jrDescribe(JrProblem *problem){
+
+    printStorage(problem);
+}
+
+int jrSolve(JrProblem *problem, JrResult *result){
+
+    int failed = 0;
+    double flops, bytes;
+
+    // The solve never writes to Matrix A or Array B, so the prepared data
+    // stays pristine and only the iteration state is reset
+    iterations = 0;
+    if(options.precision == PRECISION_CHECK)
+        failed = checkPrecision(problem);
+    else
+        problem->engine->solve(problem);
+
+    // A diverged iterate ends in inf or NaN, which every error comparison
+    // takes as converged, and any of them makes RowTest NaN. A streamed
+    // solve stops early when a block of Matrix A can not be read
+    if(problem->stream != NULL && problem->stream->failed){
+        fprintf(outputFile, "Stopped after %d iterations, Matrix A could not be read\n", iterations);
+        fprintf(stderr, "The solve stopped after %d iterations, Matrix A could not be read\n", iterations);
+        failed = 1;
+    }
+    else if(!isfinite(rowTestResult)){
+        fprintf(outputFile, "Diverged after %d iterations\n", iterations);
+        fprintf(stderr, "The solve diverged after %d iterations\n", iterations);
+        failed = 1;
+    }
+
+    result->iterations = iterations;
+    result->rowTest = rowTestResult;
+    result->time = timeSpent;
+    result->engine = problem->engine->name;
+    result->kernel = kernel->name;
+    result->storage = storageName(problem);
+    result->order = problem->J_ORDER;
+    result->threads = problem->engine->threads();
+
+    sweepCost(problem, &flops, &bytes);
+    result->flops = flops * iterations;
+    result->bytes = bytes * iterations;
+
+    return failed;
+}
+
+void jrSetInitial(JrProblem *problem, const double *x){
+
+    if(x == NULL){
+        free(problem->initial);
+        problem->initial = NULL;
+        return;
+    }
+
+    if(problem->initial == NULL)
+        problem->initial = (double*) malloc(sizeof(double) * problem->J_ORDER);
+    memcpy(problem->initial, x, sizeof(double) * problem->J_ORDER);
+}
+
+int jrReadInitial(JrProblem *problem, const char *path){
+
+    int count;
+    double *values;
+
+    if(readVectors(path, problem->J_ORDER, &count, &values) != 0)
+        return 1;
+
+    if(count != 1){
+        fprintf(stderr, "%s: expected a single initial guess, not %d\n", path, count);
+        free(values);
+        return 1;
+    }
+
+    free(problem->initial);
+    problem->initial = values;
+
+    return 0;
+}
+
+const double* jrSolution(JrProblem *problem){
+
+    return problem->solution;
+}
+
+int jrExportSolution(JrProblem *problem, const char *path){
+
+    if(problem->solution == NULL){
+        fprintf(stderr, "There is no solution to export yet\n");
+        return 1;
+    }
+
+    return writeVector(path, problem->solution, problem->J_ORDER);
+}
+
+void jrFreeProblem(JrProblem *problem){
+
+    freeData(problem);
+}
+
+void jrShutdown(void){
+
+    int e;
+
+    for(e = 0; e < ENGINES; e++){
+        if(started[e])
+            engines[e]->stop();
+        started[e] = 0;
+    }
+
+    checkpointShutdown();
+    TRACE_CLOSE();
+}
@@ -0,0 +1,136 @@
+#ifndef JACOBI_H
+#define JACOBI_H
+
+#include <stdio.h>
+
+#include "options.h"
+
+/**
+ * Solver library (libjacobi)
+ *
+ * Reads, prepares and solves a system with any of the three engines the
+ * programs used to be: serial, pthreads (worker pool and barrier, see
+ * pool.h and barrier.h) or OpenMP. The engine is picked at runtime from
+ * Options.engine when a problem is loaded; ENGINE_AUTO takes the serial one
+ * for a single thread or a small order and the pthreads one otherwise.
+ *
+ *     Options options;
+ *     JrProblem *problem;
+ *     JrResult result;
+ *
+ *     parseOptions(argc, argv, 0, 1, &options);
+ *     jrInit(&options, stdout);
+ *     problem = jrLoad(options.matrixPath);
+ *     jrPrepare(problem);
+ *     jrSolve(problem, &result);
+ *     jrFreeProblem(problem);
+ *     jrShutdown();
+ *
+ * Everything is reported to the file given to jrInit, in the format of the
+ * output files of the programs. A single problem is solved at a time.
+ */
+
+/**
+ * A system read by jrLoad
+ */
+typedef struct JrProblem JrProblem;
+
+/**
+ * Outcome of jrSolve
+ * iterations: Iterations of the solve (the most of any right-hand side or
+ * asynchronous worker)
+ * rowTest: Value computed for J_ROW_TEST (first right-hand side)
+ * time: Seconds spent in the solve
+ * engine: Name of the engine that ran it
+ * kernel: Name of the dot product kernel it used
+ * storage: "dense", "sparse" or "out-of-core" (streamed from the file)
+ * order: Order of Matrix A
+ * threads: Threads the engine ran it on
+ * flops/bytes: Floating point operations and memory traffic of its
+ * iterations, from a model of the sweep (no counters)
+ */
+typedef struct {
+
+    int iterations;
+    double rowTest;
+    double time;
+    const char *engine;
+    const char *kernel;
+    const char *storage;
+    int order;
+    int threads;
+    double flops;
+    double bytes;
+
+} JrResult;
+
+/**
+ * Pick the kernel and cache blocking for this CPU and keep a copy of
+ * options for every later call. Returns 0 on success, 1 if the options can
+ * not be combined
+ */
+JR_API int jrInit(const Options *options, FILE *report);
+
+/**
+ * Read a text, binary or Matrix Market matrix and choose its storage and
+ * engine. Returns NULL if it can not be read
+ */
+JR_API JrProblem* jrLoad(const char *path);
+
+/**
+ * Divide the system by its main diagonal and build what --method and
+ * --precision need. Returns 0 on success
+ */
+JR_API int jrPrepare(JrProblem *problem);
+
+/**
+ * With --tune, time short solves of a prepared problem to pick the kernel,
+ * threads and partition of the next solves (see tune.h). Nothing is done if
+ * they were read from the tuning cache when the problem was loaded
+ */
+JR_API void jrTune(JrProblem *problem);
+
+/**
+ * Write the storage, precision and method of a prepared problem
+ */
+JR_API void jrDescribe(JrProblem *problem);
+
+/**
+ * Solve from x = 0, or from the initial guess. The problem is left
+ * untouched, so it can be solved again. Returns 1 when the solve diverged,
+ * an out-of-core Matrix A could not be read or --precision check finds the
+ * float solve off, 0 otherwise
+ */
+JR_API int jrSolve(JrProblem *problem, JrResult *result);
+
+/**
+ * Start the next solves from a copy of the order values of x, NULL goes back
+ * to x = 0. Only used by solves of a single right-hand side
+ */
+JR_API void jrSetInitial(JrProblem *problem, const double *x);
+
+/**
+ * jrSetInitial from a file in the format of jrExportSolution (or any single
+ * vector readVectors accepts). Returns 0 on success, 1 on failure
+ */
+JR_API int jrReadInitial(JrProblem *problem, const char *path);
+
+/**
+ * x of the last solve, order values, or NULL before the first solve
+ */
+JR_API const double* jrSolution(JrProblem *problem);
+
+/**
+ * Write x of the last solve to path as a Matrix Market array. Returns 0 on
+ * success, 1 on failure
+ */
+JR_API int jrExportSolution(JrProblem *problem, const char *path);
+
+JR_API void jrFreeProblem(JrProblem *problem);
+
+/**
+ * Stop the threads of every engine started
+ */
+JR_API void jrShutdown(void);
+
+#endif
@@ -0,0 +1,668 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "kernels.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define JR_X86 1
+#endif
+
+// Column blocks are a multiple of this many doubles (a few cache lines)
+#define BLOCK_ALIGN 64
+
+// Cache sizes assumed when neither sysconf nor sysfs report them
+#define DEFAULT_L1 (32 * 1024)
+#define DEFAULT_L2 (256 * 1024)
+
+/**
+ * Portable fallback, four accumulators break the dependent-add chain
+ */
+static double dotScalar(const double *row, const double *x, int n){
+
+    int j;
+    double s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+
+    for(j = 0; j + 4 <= n; j += 4){
+        s0 = s0 + row[j] * x[j];
+        s1 = s1 + row[j + 1] * x[j + 1];
+        s2 = s2 + row[j + 2] * x[j + 2];
+        s3 = s3 + row[j + 3] * x[j + 3];
+    }
+
+    for(; j < n; j++){
+        s0 = s0 + row[j] * x[j];
+    }
+
+    return (s0 + s1) + (s2 + s3);
+}
+
+static double dotFloatScalar(const float *row, const double *x, int n){
+
+    int j;
+    double s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+
+    for(j = 0; j + 4 <= n; j += 4){
+        s0 = s0 + (double) row[j] * x[j];
+        s1 = s1 + (double) row[j + 1] * x[j + 1];
+        s2 = s2 + (double) row[j + 2] * x[j + 2];
+        s3 = s3 + (double) row[j + 3] * x[j + 3];
+    }
+
+    for(; j < n; j++){
+        s0 = s0 + (double) row[j] * x[j];
+    }
+
+    return (s0 + s1) + (s2 + s3);
+}
+
+/**
+ * Four vectors at a time, the row stays in cache between the groups
+ */
+static void multiDotScalar(const double *row, const double *X, int ldx,
+        int count, int n, double *result){
+
+    int j, r;
+    double s0, s1, s2, s3;
+    const double *x;
+
+    for(r = 0; r + 4 <= count; r += 4){
+        s0 = s1 = s2 = s3 = 0;
+        x = X + r;
+        for(j = 0; j < n; j++, x += ldx){
+            s0 = s0 + row[j] * x[0];
+            s1 = s1 + row[j] * x[1];
+            s2 = s2 + row[j] * x[2];
+            s3 = s3 + row[j] * x[3];
+        }
+        result[r] = s0;
+        result[r + 1] = s1;
+        result[r + 2] = s2;
+        result[r + 3] = s3;
+    }
+
+    for(; r < count; r++){
+        s0 = 0;
+        x = X + r;
+        for(j = 0; j < n; j++, x += ldx){
+            s0 = s0 + row[j] * x[0];
+        }
+        result[r] = s0;
+    }
+}
+
+/**
+ * Four rows at a time, each value of x is loaded once for the four of them
+ */
+static void dot4Scalar(const double *row, int lda, const double *x, int n, double *result){
+
+    int j;
+    double s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    const double *row1 = row + lda;
+    const double *row2 = row + 2 * (size_t) lda;
+    const double *row3 = row + 3 * (size_t) lda;
+
+    for(j = 0; j < n; j++){
+        s0 = s0 + row[j] * x[j];
+        s1 = s1 + row1[j] * x[j];
+        s2 = s2 + row2[j] * x[j];
+        s3 = s3 + row3[j] * x[j];
+    }
+
+    result[0] = s0;
+    result[1] = s1;
+    result[2] = s2;
+    result[3] = s3;
+}
+
+#ifdef JR_X86
+
+/**
+ * AVX2 + FMA: four 4-wide accumulators, 16 values per iteration
+ */
+__attribute__((target("avx2,fma")))
+static double dotAvx2(const double *row, const double *x, int n){
+
+    int j;
+    double result;
+    __m256d s0 = _mm256_setzero_pd();
+    __m256d s1 = _mm256_setzero_pd();
+    __m256d s2 = _mm256_setzero_pd();
+    __m256d s3 = _mm256_setzero_pd();
+    __m128d low, high;
+
+    for(j = 0; j + 16 <= n; j += 16){
+        s0 = _mm256_fmadd_pd(_mm256_loadu_pd(row + j), _mm256_loadu_pd(x + j), s0);
+        s1 = _mm256_fmadd_pd(_mm256_loadu_pd(row + j + 4), _mm256_loadu_pd(x + j + 4), s1);
+        s2 = _mm256_fmadd_pd(_mm256_loadu_pd(row + j + 8), _mm256_loadu_pd(x + j + 8), s2);
+        s3 = _mm256_fmadd_pd(_mm256_loadu_pd(row + j + 12), _mm256_loadu_pd(x + j + 12), s3);
+    }
+
+    for(; j + 4 <= n; j += 4){
+        s0 = _mm256_fmadd_pd(_mm256_loadu_pd(row + j), _mm256_loadu_pd(x + j), s0);
+    }
+
+    s0 = _mm256_add_pd(_mm256_add_pd(s0, s1), _mm256_add_pd(s2, s3));
+    low = _mm256_castpd256_pd128(s0);
+    high = _mm256_extractf128_pd(s0, 1);
+    low = _mm_add_pd(low, high);
+    result = _mm_cvtsd_f64(_mm_add_sd(low, _mm_unpackhi_pd(low, low)));
+
+    for(; j < n; j++){
+        result = result + row[j] * x[j];
+    }
+
+    return result;
+}
+
+__attribute__((target("avx2,fma")))
+static double dotFloatAvx2(const float *row, const double *x, int n){
+
+    int j;
+    double result;
+    __m256d s0 = _mm256_setzero_pd();
+    __m256d s1 = _mm256_setzero_pd();
+    __m256d s2 = _mm256_setzero_pd();
+    __m256d s3 = _mm256_setzero_pd();
+    __m128d low, high;
+
+    for(j = 0; j + 16 <= n; j += 16){
+        s0 = _mm256_fmadd_pd(_mm256_cvtps_pd(_mm_loadu_ps(row + j)), _mm256_loadu_pd(x + j), s0);
+        s1 = _mm256_fmadd_pd(_mm256_cvtps_pd(_mm_loadu_ps(row + j + 4)), _mm256_loadu_pd(x + j + 4), s1);
+        s2 = _mm256_fmadd_pd(_mm256_cvtps_pd(_mm_loadu_ps(row + j + 8)), _mm256_loadu_pd(x + j + 8), s2);
+        s3 = _mm256_fmadd_pd(_mm256_cvtps_pd(_mm_loadu_ps(row + j + 12)), _mm256_loadu_pd(x + j + 12), s3);
+    }
+
+    for(; j + 4 <= n; j += 4){
+        s0 = _mm256_fmadd_pd(_mm256_cvtps_pd(_mm_loadu_ps(row + j)), _mm256_loadu_pd(x + j), s0);
+    }
+
+    s0 = _mm256_add_pd(_mm256_add_pd(s0, s1), _mm256_add_pd(s2, s3));
+    low = _mm256_castpd256_pd128(s0);
+    high = _mm256_extractf128_pd(s0, 1);
+    low = _mm_add_pd(low, high);
+    result = _mm_cvtsd_f64(_mm_add_sd(low, _mm_unpackhi_pd(low, low)));
+
+    for(; j < n; j++){
+        result = result + (double) row[j] * x[j];
+    }
+
+    return result;
+}
+
+/**
+ * Sixteen vectors at a time in four registers, each value of the row is
+ * broadcast once per group
+ */
+__attribute__((target("avx2,fma")))
+static void multiDotAvx2(const double *row, const double *X, int ldx,
+        int count, int n, double *result){
+
+    int j, r;
+    __m256d a, s0, s1, s2, s3;
+    const double *x;
+
+    for(r = 0; r + 16 <= count; r += 16){
+        s0 = s1 = s2 = s3 = _mm256_setzero_pd();
+        x = X + r;
+        for(j = 0; j < n; j++, x += ldx){
+            a = _mm256_broadcast_sd(row + j);
+            s0 = _mm256_fmadd_pd(a, _mm256_loadu_pd(x), s0);
+            s1 = _mm256_fmadd_pd(a, _mm256_loadu_pd(x + 4), s1);
+            s2 = _mm256_fmadd_pd(a, _mm256_loadu_pd(x + 8), s2);
+            s3 = _mm256_fmadd_pd(a, _mm256_loadu_pd(x + 12), s3);
+        }
+        _mm256_storeu_pd(result + r, s0);
+        _mm256_storeu_pd(result + r + 4, s1);
+        _mm256_storeu_pd(result + r + 8, s2);
+        _mm256_storeu_pd(result + r + 12, s3);
+    }
+
+    // Fewer vectors left than registers, four consecutive values of the row
+    // go to separate accumulators instead
+    for(; r + 4 <= count; r += 4){
+        s0 = s1 = s2 = s3 = _mm256_setzero_pd();
+        x = X + r;
+        for(j = 0; j + 4 <= n; j += 4, x += 4 * (size_t) ldx){
+            s0 = _mm256_fmadd_pd(_mm256_broadcast_sd(row + j), _mm256_loadu_pd(x), s0);
+            s1 = _mm256_fmadd_pd(_mm256_broadcast_sd(row + j + 1), _mm256_loadu_pd(x + ldx), s1);
+            s2 = _mm256_fmadd_pd(_mm256_broadcast_sd(row + j + 2), _mm256_loadu_pd(x + 2 * ldx), s2);
+            s3 = _mm256_fmadd_pd(_mm256_broadcast_sd(row + j + 3), _mm256_loadu_pd(x + 3 * ldx), s3);
+        }
+        for(; j < n; j++, x += ldx){
+            s0 = _mm256_fmadd_pd(_mm256_broadcast_sd(row + j), _mm256_loadu_pd(x), s0);
+        }
+        s0 = _mm256_add_pd(_mm256_add_pd(s0, s1), _mm256_add_pd(s2, s3));
+        _mm256_storeu_pd(result + r, s0);
+    }
+
+    if(r < count)
+        multiDotScalar(row, X + r, ldx, count - r, n, result + r);
+}
+
+__attribute__((target("avx2,fma")))
+static inline double sumAvx2(__m256d s){
+
+    __m128d low = _mm256_castpd256_pd128(s);
+    __m128d high = _mm256_extractf128_pd(s, 1);
+
+    low = _mm_add_pd(low, high);
+
+    return _mm_cvtsd_f64(_mm_add_sd(low, _mm_unpackhi_pd(low, low)));
+}
+
+/**
+ * Two 4-wide accumulators per row, eight in flight to cover the FMA latency
+ */
+__attribute__((target("avx2,fma")))
+static void dot4Avx2(const double *row, int lda, const double *x, int n, double *result){
+
+    int j;
+    __m256d v, w;
+    __m256d s0 = _mm256_setzero_pd(), t0 = _mm256_setzero_pd();
+    __m256d s1 = _mm256_setzero_pd(), t1 = _mm256_setzero_pd();
+    __m256d s2 = _mm256_setzero_pd(), t2 = _mm256_setzero_pd();
+    __m256d s3 = _mm256_setzero_pd(), t3 = _mm256_setzero_pd();
+    const double *row1 = row + lda;
+    const double *row2 = row + 2 * (size_t) lda;
+    const double *row3 = row + 3 * (size_t) lda;
+
+    for(j = 0; j + 8 <= n; j += 8){
+        v = _mm256_loadu_pd(x + j);
+        w = _mm256_loadu_pd(x + j + 4);
+        s0 = _mm256_fmadd_pd(_mm256_loadu_pd(row + j), v, s0);
+        t0 = _mm256_fmadd_pd(_mm256_loadu_pd(row + j + 4), w, t0);
+        s1 = _mm256_fmadd_pd(_mm256_loadu_pd(row1 + j), v, s1);
+        t1 = _mm256_fmadd_pd(_mm256_loadu_pd(row1 + j + 4), w, t1);
+        s2 = _mm256_fmadd_pd(_mm256_loadu_pd(row2 + j), v, s2);
+        t2 = _mm256_fmadd_pd(_mm256_loadu_pd(row2 + j + 4), w, t2);
+        s3 = _mm256_fmadd_pd(_mm256_loadu_pd(row3 + j), v, s3);
+        t3 = _mm256_fmadd_pd(_mm256_loadu_pd(row3 + j + 4), w, t3);
+    }
+
+    for(; j + 4 <= n; j += 4){
+        v = _mm256_loadu_pd(x + j);
+        s0 = _mm256_fmadd_pd(_mm256_loadu_pd(row + j), v, s0);
+        s1 = _mm256_fmadd_pd(_mm256_loadu_pd(row1 + j), v, s1);
+        s2 = _mm256_fmadd_pd(_mm256_loadu_pd(row2 + j), v, s2);
+        s3 = _mm256_fmadd_pd(_mm256_loadu_pd(row3 + j), v, s3);
+    }
+
+    result[0] = sumAvx2(_mm256_add_pd(s0, t0));
+    result[1] = sumAvx2(_mm256_add_pd(s1, t1));
+    result[2] = sumAvx2(_mm256_add_pd(s2, t2));
+    result[3] = sumAvx2(_mm256_add_pd(s3, t3));
+
+    for(; j < n; j++){
+        result[0] = result[0] + row[j] * x[j];
+        result[1] = result[1] + row1[j] * x[j];
+        result[2] = result[2] + row2[j] * x[j];
+        result[3] = result[3] + row3[j] * x[j];
+    }
+}
+
+/**
+ * AVX-512: four 8-wide accumulators, the tail uses a masked load
+ */
+__attribute__((target("avx512f")))
+static double dotAvx512(const double *row, const double *x, int n){
+
+    int j;
+    __m512d s0 = _mm512_setzero_pd();
+    __m512d s1 = _mm512_setzero_pd();
+    __m512d s2 = _mm512_setzero_pd();
+    __m512d s3 = _mm512_setzero_pd();
+    __mmask8 mask;
+
+    for(j = 0; j + 32 <= n; j += 32){
+        s0 = _mm512_fmadd_pd(_mm512_loadu_pd(row + j), _mm512_loadu_pd(x + j), s0);
+        s1 = _mm512_fmadd_pd(_mm512_loadu_pd(row + j + 8), _mm512_loadu_pd(x + j + 8), s1);
+        s2 = _mm512_fmadd_pd(_mm512_loadu_pd(row + j + 16), _mm512_loadu_pd(x + j + 16), s2);
+        s3 = _mm512_fmadd_pd(_mm512_loadu_pd(row + j + 24), _mm512_loadu_pd(x + j + 24), s3);
+    }
+
+    for(; j + 8 <= n; j += 8){
+        s0 = _mm512_fmadd_pd(_mm512_loadu_pd(row + j), _mm512_loadu_pd(x + j), s0);
+    }
+
+    if(j < n){
+        mask = (__mmask8) ((1u << (n - j)) - 1);
+        s1 = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(mask, row + j),
+                _mm512_maskz_loadu_pd(mask, x + j), s1);
+    }
+
+    s0 = _mm512_add_pd(_mm512_add_pd(s0, s1), _mm512_add_pd(s2, s3));
+
+    return _mm512_reduce_add_pd(s0);
+}
+
+__attribute__((target("avx512f")))
+static double dotFloatAvx512(const float *row, const double *x, int n){
+
+    int j;
+    double result;
+    __m512d s0 = _mm512_setzero_pd();
+    __m512d s1 = _mm512_setzero_pd();
+    __m512d s2 = _mm512_setzero_pd();
+    __m512d s3 = _mm512_setzero_pd();
+
+    for(j = 0; j + 32 <= n; j += 32){
+        s0 = _mm512_fmadd_pd(_mm512_cvtps_pd(_mm256_loadu_ps(row + j)), _mm512_loadu_pd(x + j), s0);
+        s1 = _mm512_fmadd_pd(_mm512_cvtps_pd(_mm256_loadu_ps(row + j + 8)), _mm512_loadu_pd(x + j + 8), s1);
+        s2 = _mm512_fmadd_pd(_mm512_cvtps_pd(_mm256_loadu_ps(row + j + 16)), _mm512_loadu_pd(x + j + 16), s2);
+        s3 = _mm512_fmadd_pd(_mm512_cvtps_pd(_mm256_loadu_ps(row + j + 24)), _mm512_loadu_pd(x + j + 24), s3);
+    }
+
+    for(; j + 8 <= n; j += 8){
+        s0 = _mm512_fmadd_pd(_mm512_cvtps_pd(_mm256_loadu_ps(row + j)), _mm512_loadu_pd(x + j), s0);
+    }
+
+    s0 = _mm512_add_pd(_mm512_add_pd(s0, s1), _mm512_add_pd(s2, s3));
+    result = _mm512_reduce_add_pd(s0);
+
+    for(; j < n; j++){
+        result = result + (double) row[j] * x[j];
+    }
+
+    return result;
+}
+
+/**
+ * Thirty-two vectors at a time, the last group uses masked loads
+ */
+__attribute__((target("avx512f")))
+static void multiDotAvx512(const double *row, const double *X, int ldx,
+        int count, int n, double *result){
+
+    int j, r;
+    __m512d a, s0, s1, s2, s3;
+    __mmask8 mask;
+    const double *x;
+
+    for(r = 0; r + 32 <= count; r += 32){
+        s0 = s1 = s2 = s3 = _mm512_setzero_pd();
+        x = X + r;
+        for(j = 0; j < n; j++, x += ldx){
+            a = _mm512_set1_pd(row[j]);
+            s0 = _mm512_fmadd_pd(a, _mm512_loadu_pd(x), s0);
+            s1 = _mm512_fmadd_pd(a, _mm512_loadu_pd(x + 8), s1);
+            s2 = _mm512_fmadd_pd(a, _mm512_loadu_pd(x + 16), s2);
+            s3 = _mm512_fmadd_pd(a, _mm512_loadu_pd(x + 24), s3);
+        }
+        _mm512_storeu_pd(result + r, s0);
+        _mm512_storeu_pd(result + r + 8, s1);
+        _mm512_storeu_pd(result + r + 16, s2);
+        _mm512_storeu_pd(result + r + 24, s3);
+    }
+
+    // Sixteen vectors in two registers, two consecutive values of the row
+    // go to separate accumulators
+    for(; r + 16 <= count; r += 16){
+        s0 = s1 = s2 = s3 = _mm512_setzero_pd();
+        x = X + r;
+        for(j = 0; j + 2 <= n; j += 2, x += 2 * (size_t) ldx){
+            a = _mm512_set1_pd(row[j]);
+            s0 = _mm512_fmadd_pd(a, _mm512_loadu_pd(x), s0);
+            s1 = _mm512_fmadd_pd(a, _mm512_loadu_pd(x + 8), s1);
+            a = _mm512_set1_pd(row[j + 1]);
+            s2 = _mm512_fmadd_pd(a, _mm512_loadu_pd(x + ldx), s2);
+            s3 = _mm512_fmadd_pd(a, _mm512_loadu_pd(x + ldx + 8), s3);
+        }
+        for(; j < n; j++, x += ldx){
+            a = _mm512_set1_pd(row[j]);
+            s0 = _mm512_fmadd_pd(a, _mm512_loadu_pd(x), s0);
+            s1 = _mm512_fmadd_pd(a, _mm512_loadu_pd(x + 8), s1);
+        }
+        _mm512_storeu_pd(result + r, _mm512_add_pd(s0, s2));
+        _mm512_storeu_pd(result + r + 8, _mm512_add_pd(s1, s3));
+    }
+
+    // Fewer vectors left than registers, four consecutive values of the row
+    // go to separate accumulators instead
+    for(; r < count; r += 8){
+        mask = count - r >= 8 ? (__mmask8) 0xFF : (__mmask8) ((1u << (count - r)) - 1);
+        s0 = s1 = s2 = s3 = _mm512_setzero_pd();
+        x = X + r;
+        for(j = 0; j + 4 <= n; j += 4, x += 4 * (size_t) ldx){
+            s0 = _mm512_fmadd_pd(_mm512_set1_pd(row[j]), _mm512_maskz_loadu_pd(mask, x), s0);
+            s1 = _mm512_fmadd_pd(_mm512_set1_pd(row[j + 1]), _mm512_maskz_loadu_pd(mask, x + ldx), s1);
+            s2 = _mm512_fmadd_pd(_mm512_set1_pd(row[j + 2]), _mm512_maskz_loadu_pd(mask, x + 2 * ldx), s2);
+            s3 = _mm512_fmadd_pd(_mm512_set1_pd(row[j + 3]), _mm512_maskz_loadu_pd(mask, x + 3 * ldx), s3);
+        }
+        for(; j < n; j++, x += ldx){
+            s0 = _mm512_fmadd_pd(_mm512_set1_pd(row[j]), _mm512_maskz_loadu_pd(mask, x), s0);
+        }
+        s0 = _mm512_add_pd(_mm512_add_pd(s0, s1), _mm512_add_pd(s2, s3));
+        _mm512_mask_storeu_pd(result + r, mask, s0);
+    }
+}
+
+/**
+ * Two 8-wide accumulators per row, the tail uses masked loads
+ */
+__attribute__((target("avx512f")))
+static void dot4Avx512(const double *row, int lda, const double *x, int n, double *result){
+
+    int j;
+    __m512d v, w;
+    __m512d s0 = _mm512_setzero_pd(), t0 = _mm512_setzero_pd();
+    __m512d s1 = _mm512_setzero_pd(), t1 = _mm512_setzero_pd();
+    __m512d s2 = _mm512_setzero_pd(), t2 = _mm512_setzero_pd();
+    __m512d s3 = _mm512_setzero_pd(), t3 = _mm512_setzero_pd();
+    __mmask8 mask;
+    const double *row1 = row + lda;
+    const double *row2 = row + 2 * (size_t) lda;
+    const double *row3 = row + 3 * (size_t) lda;
+
+    for(j = 0; j + 16 <= n; j += 16){
+        v = _mm512_loadu_pd(x + j);
+        w = _mm512_loadu_pd(x + j + 8);
+        s0 = _mm512_fmadd_pd(_mm512_loadu_pd(row + j), v, s0);
+        t0 = _mm512_fmadd_pd(_mm512_loadu_pd(row + j + 8), w, t0);
+        s1 = _mm512_fmadd_pd(_mm512_loadu_pd(row1 + j), v, s1);
+        t1 = _mm512_fmadd_pd(_mm512_loadu_pd(row1 + j + 8), w, t1);
+        s2 = _mm512_fmadd_pd(_mm512_loadu_pd(row2 + j), v, s2);
+        t2 = _mm512_fmadd_pd(_mm512_loadu_pd(row2 + j + 8), w, t2);
+        s3 = _mm512_fmadd_pd(_mm512_loadu_pd(row3 + j), v, s3);
+        t3 = _mm512_fmadd_pd(_mm512_loadu_pd(row3 + j + 8), w, t3);
+    }
+
+    for(; j < n; j += 8){
+        mask = n - j >= 8 ? (__mmask8) 0xFF : (__mmask8) ((1u << (n - j)) - 1);
+        v = _mm512_maskz_loadu_pd(mask, x + j);
+        s0 = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(mask, row + j), v, s0);
+        s1 = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(mask, row1 + j), v, s1);
+        s2 = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(mask, row2 + j), v, s2);
+        s3 = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(mask, row3 + j), v, s3);
+    }
+
+    result[0] = _mm512_reduce_add_pd(_mm512_add_pd(s0, t0));
+    result[1] = _mm512_reduce_add_pd(_mm512_add_pd(s1, t1));
+    result[2] = _mm512_reduce_add_pd(_mm512_add_pd(s2, t2));
+    result[3] = _mm512_reduce_add_pd(_mm512_add_pd(s3, t3));
+}
+
+#endif
+
+// Ordered from the most to the least preferred
+static const Kernel kernels[] = {
+#ifdef JR_X86
+    { "avx512", dotAvx512, dotFloatAvx512, multiDotAvx512, dot4Avx512 },
+    { "avx2", dotAvx2, dotFloatAvx2, multiDotAvx2, dot4Avx2 },
+#endif
+    { "scalar", dotScalar, dotFloatScalar, multiDotScalar, dot4Scalar },
+};
+
+#define NUMBER_OF_KERNELS ((int) (sizeof(kernels) / sizeof(kernels[0])))
+
+static int isSupported(const Kernel *kernel){
+
+#ifdef JR_X86
+    __builtin_cpu_init();
+
+    if(kernel->dot == dotAvx512)
+        return __builtin_cpu_supports("avx512f");
+
+    if(kernel->dot == dotAvx2)
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+
+    return 1;
+}
+
+const Kernel* findKernel(const char *name){
+
+    int i;
+
+    for(i = 0; i < NUMBER_OF_KERNELS; i++){
+        if(strcmp(kernels[i].name, name) == 0)
+            return isSupported(&kernels[i]) ? &kernels[i] : NULL;
+    }
+
+    return NULL;
+}
+
+const Kernel* nextKernel(const Kernel *kernel){
+
+    int i = kernel == NULL ? 0 : (int) (kernel - kernels) + 1;
+
+    for(; i < NUMBER_OF_KERNELS; i++){
+        if(isSupported(&kernels[i]))
+            return &kernels[i];
+    }
+
+    return NULL;
+}
+
+const Kernel* selectKernel(void){
+
+    int i;
+    const char *env = getenv("JR_KERNEL");
+    const Kernel *kernel;
+
+    if(env != NULL){
+        kernel = findKernel(env);
+        if(kernel != NULL)
+            return kernel;
+
+        fprintf(stderr, "Kernel %s is not available, picking one automatically\n", env);
+    }
+
+    for(i = 0; i < NUMBER_OF_KERNELS; i++){
+        if(isSupported(&kernels[i]))
+            return &kernels[i];
+    }
+
+    return &kernels[NUMBER_OF_KERNELS - 1];
+}
+
+/**
+ * Size in bytes of the data or unified cache of the given level of CPU 0,
+ * from sysfs, 0 if it is not listed
+ */
+static long sysfsCacheSize(int level){
+
+    int index, cacheLevel;
+    long size;
+    char path[96], type[32], unit;
+    FILE *file;
+
+    for(index = 0; ; index++){
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/level", index);
+        file = fopen(path, "r");
+        if(file == NULL)
+            return 0;
+        if(fscanf(file, "%d", &cacheLevel) != 1)
+            cacheLevel = 0;
+        fclose(file);
+
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/type", index);
+        file = fopen(path, "r");
+        if(file == NULL)
+            continue;
+        if(fscanf(file, "%31s", type) != 1)
+            type[0] = 0;
+        fclose(file);
+
+        if(cacheLevel != level || strcmp(type, "Instruction") == 0)
+            continue;
+
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/size", index);
+        file = fopen(path, "r");
+        if(file == NULL)
+            return 0;
+        unit = 0;
+        if(fscanf(file, "%ld%c", &size, &unit) < 1)
+            size = 0;
+        fclose(file);
+
+        if(unit == 'K')
+            size = size * 1024;
+        else if(unit == 'M')
+            size = size * 1024 * 1024;
+
+        return size;
+    }
+}
+
+void detectBlocking(Blocking *blocking){
+
+    long columns;
+    const char *env;
+
+    blocking->l1 = sysconf(_SC_LEVEL1_DCACHE_SIZE);
+    blocking->l2 = sysconf(_SC_LEVEL2_CACHE_SIZE);
+    if(blocking->l1 <= 0)
+        blocking->l1 = sysfsCacheSize(1);
+    if(blocking->l2 <= 0)
+        blocking->l2 = sysfsCacheSize(2);
+    if(blocking->l1 <= 0)
+        blocking->l1 = DEFAULT_L1;
+    if(blocking->l2 <= 0)
+        blocking->l2 = DEFAULT_L2;
+
+    // Half of L2 for the block of x, the rest for the rows streaming through
+    columns = blocking->l2 / 2 / sizeof(double);
+    columns = columns - columns % BLOCK_ALIGN;
+    if(columns < BLOCK_ALIGN)
+        columns = BLOCK_ALIGN;
+
+    blocking->columns = columns > 1 << 30 ? 1 << 30 : (int) columns;
+
+    env = getenv("JR_BLOCK_COLUMNS");
+    if(env != NULL && atoi(env) > 0)
+        blocking->columns = atoi(env);
+}
+
+void multiRowDot(const Kernel *kernel, const Blocking *blocking, const double *A, int lda,
+        int rows, const double *x, int n, double *result){
+
+    int i, j, width;
+    double tile[ROW_TILE];
+    const double *row;
+
+    for(i = 0; i < rows; i++){
+        result[i] = 0;
+    }
+
+    // One block of x at a time over every row, it stays in L2 while the rows
+    // go by
+    for(j = 0; j < n; j += blocking->columns){
+        width = n - j < blocking->columns ? n - j : blocking->columns;
+
+        for(i = 0; i + ROW_TILE <= rows; i += ROW_TILE){
+            row = A + (size_t) i * lda + j;
+            kernel->dot4(row, lda, x + j, width, tile);
+            result[i] += tile[0];
+            result[i + 1] += tile[1];
+            result[i + 2] += tile[2];
+            result[i + 3] += tile[3];
+        }
+
+        for(; i < rows; i++){
+            result[i] += kernel->dot(A + (size_t) i * lda + j, x + j, width);
+        }
+    }
+}
@@ -0,0 +1,101 @@
+#ifndef KERNELS_H
+#define KERNELS_H
+
+/**
+ * Dot product kernels used by the Jacobi-Richardson sweep
+ *
+ * Each kernel computes sum(row[j] * x[j]) for j in [0, n) using several
+ * independent accumulators, so consecutive additions do not wait on each
+ * other. The best kernel supported by the CPU is picked at runtime through
+ * CPUID, the JR_KERNEL environment variable (scalar, avx2, avx512) can force
+ * a specific one.
+ */
+
+typedef double (*DotKernel)(const double *row, const double *x, int n);
+
+/**
+ * Same product with the row stored as float, every value is widened to
+ * double before the multiplication so the accumulation stays in double
+ */
+typedef double (*DotFloatKernel)(const float *row, const double *x, int n);
+
+/**
+ * Row times a block of vectors, result[r] = sum(row[j] * X[j * ldx + r]) for
+ * r in [0, count). The vectors are interleaved, so every value of the row is
+ * loaded once and used for all of them
+ */
+typedef void (*MultiDotKernel)(const double *row, const double *X, int ldx,
+        int count, int n, double *result);
+
+/**
+ * Four rows against the same x, result[r] = sum(row[r * lda + j] * x[j]) for
+ * r in [0, 4). Each value of x is loaded once and used for the four rows
+ */
+typedef void (*Dot4Kernel)(const double *row, int lda, const double *x, int n,
+        double *result);
+
+typedef struct {
+
+    const char *name;
+    DotKernel dot;
+    DotFloatKernel dotFloat;
+    MultiDotKernel multiDot;
+    Dot4Kernel dot4;
+
+} Kernel;
+
+// Rows per register tile of multiRowDot
+#define ROW_TILE 4
+
+/**
+ * Cache blocking of multiRowDot
+ * l1/l2: Data cache sizes in bytes, from sysconf, sysfs or a default
+ * columns: Values of x per column block, half of L2
+ *
+ * Only L2 sizes the blocks, l1 is just reported. A register tile loads each
+ * value of x once for ROW_TILE rows, so x is a fifth of the loads and the
+ * sweep is bound by the rows of A coming from memory: blocks of x sized for
+ * L1 ran no faster than L2 ones (about 11 GB/s at 4000 x 8000 and at
+ * 64 x 600000). Below 131072 columns for a 2M L2 the block is the whole of x.
+ */
+typedef struct {
+
+    long l1;
+    long l2;
+    int columns;
+
+} Blocking;
+
+/**
+ * Read the cache hierarchy of the CPU and size the blocks. The
+ * JR_BLOCK_COLUMNS environment variable overrides the column block
+ */
+void detectBlocking(Blocking *blocking);
+
+/**
+ * result[i] = sum(A[i * lda + j] * x[j]) for i in [0, rows), with the rows
+ * in register tiles of ROW_TILE (kernel->dot4) and x split in blocks of
+ * blocking->columns, so a block of x stays in cache while every row is
+ * multiplied by it instead of being reloaded for each row
+ */
+void multiRowDot(const Kernel *kernel, const Blocking *blocking, const double *A, int lda,
+        int rows, const double *x, int n, double *result);
+
+/**
+ * Kernel chosen for this machine, honoring JR_KERNEL when it is supported
+ */
+const Kernel* selectKernel(void);
+
+/**
+ * Kernel with the given name, NULL if it does not exist or the CPU does not
+ * support it
+ */
+const Kernel* findKernel(const char *name);
+
+/**
+ * Supported kernel after the given one, from the most to the least
+ * preferred. NULL gives the first one, and the last one gives NULL
+ */
+const Kernel* nextKernel(const Kernel *kernel);
+
+#endif
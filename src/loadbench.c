@@ -0,0 +1,165 @@
+#include <stdio.h>
+#include <time.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "matrixio.h"
+#include "textparse.h"
+
+/**
+ * Compares the original fscanf loader with the chunked parallel loader
+ *
+ * Every loader runs a few times and the best time is reported. The values
+ * read by the parallel loader are checked against the fscanf ones.
+ */
+
+#define RUNS 3
+
+static double elapsed(struct timespec start, struct timespec finish){
+    return (finish.tv_sec - start.tv_sec) + (finish.tv_nsec - start.tv_nsec) / 1000000000.0;
+}
+
+/**
+ * The loader used by the solvers before the chunked parser: one malloc per
+ * row and one fscanf per value
+ */
+static int loadScanf(const char *path, int order, double **rows, double *b){
+
+    int i, j;
+    int header[3];
+    double error;
+    FILE *file = fopen(path, "r");
+
+    if(file == NULL)
+        return 1;
+
+    fscanf(file, "%d%d%lf%d", &header[0], &header[1], &error, &header[2]);
+
+    for(i = 0; i < order; i++){
+        for(j = 0; j < order; j++){
+            fscanf(file, "%lf", &rows[i][j]);
+        }
+    }
+
+    for(i = 0; i < order; i++){
+        fscanf(file, "%lf", &b[i]);
+    }
+
+    fclose(file);
+
+    return 0;
+}
+
+static int loadChunked(const char *path, int threads, double *A, int lda, double *b){
+
+    int status;
+    TextMatrix text;
+    FILE *file = fopen(path, "r");
+
+    if(file == NULL)
+        return 1;
+
+    status = openTextMatrix(fileno(file), &text);
+    if(status == 0)
+        status = parseTextMatrix(&text, A, lda, b, threads);
+
+    closeTextMatrix(&text);
+    fclose(file);
+
+    return status;
+}
+
+static double** allocateRows(int order){
+
+    int i;
+    double **rows = (double**) malloc(sizeof(double*) * order);
+
+    for(i = 0; i < order; i++){
+        rows[i] = (double*) malloc(sizeof(double) * order);
+    }
+
+    return rows;
+}
+
+int main(int argc, char* argv[]){
+
+    int i, r;
+    int order, lda;
+    int threads = loaderThreads();
+    double best, t;
+    double **reference;
+    double *A;
+    double *referenceB, *b;
+    struct timespec start, finish;
+    TextMatrix text;
+
+    if(argc < 2){
+        printf("Invalid number of arguments: ./loadbench matrix.txt [THREADS]\n");
+        return 1;
+    }
+
+    if(argc > 2)
+        threads = atoi(argv[2]);
+
+    FILE *file = fopen(argv[1], "r");
+    if(file == NULL || openTextMatrix(fileno(file), &text) != 0){
+        fprintf(stderr, "Could not open %s\n", argv[1]);
+        return 1;
+    }
+    order = text.order;
+    closeTextMatrix(&text);
+    fclose(file);
+
+    reference = allocateRows(order);
+    A = allocateMatrix(order, &lda);
+    referenceB = (double*) malloc(sizeof(double) * order);
+    b = (double*) malloc(sizeof(double) * order);
+
+    printf("Matrix %s, order %d\n", argv[1], order);
+
+    best = 0;
+    for(r = 0; r < RUNS; r++){
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        loadScanf(argv[1], order, reference, referenceB);
+        clock_gettime(CLOCK_MONOTONIC, &finish);
+        t = elapsed(start, finish);
+        if(r == 0 || t < best)
+            best = t;
+    }
+    printf("fscanf:              %lf s\n", best);
+
+    // 1, 2, 4, ... threads, always finishing with the requested number
+    for(i = 1; ; i = i * 2){
+        if(i > threads)
+            i = threads;
+
+        best = 0;
+        for(r = 0; r < RUNS; r++){
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            if(loadChunked(argv[1], i, A, lda, b) != 0)
+                return 1;
+            clock_gettime(CLOCK_MONOTONIC, &finish);
+            t = elapsed(start, finish);
+            if(r == 0 || t < best)
+                best = t;
+        }
+
+        for(r = 0; r < order; r++){
+            if(memcmp(A + (size_t) r * lda, reference[r], sizeof(double) * order) != 0){
+                fprintf(stderr, "Mismatch on row %d\n", r);
+                return 1;
+            }
+        }
+        if(memcmp(b, referenceB, sizeof(double) * order) != 0){
+            fprintf(stderr, "Mismatch on Array B\n");
+            return 1;
+        }
+
+        printf("chunked %2d threads:  %lf s\n", i, best);
+
+        if(i == threads)
+            break;
+    }
+
+    return 0;
+}
@@ -0,0 +1,214 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "matrixio.h"
+
+int leadingDimension(int order){
+
+    int perLine = JRBIN_ALIGN / sizeof(double);
+
+    return ((order + perLine - 1) / perLine) * perLine;
+}
+
+double* allocateMatrix(int order, int *lda){
+
+    int i;
+    void *matrix;
+
+    *lda = leadingDimension(order);
+
+    if(posix_memalign(&matrix, JRBIN_ALIGN, sizeof(double) * (size_t) order * *lda) != 0)
+        return NULL;
+
+    for(i = 0; i < order; i++){
+        memset((double*) matrix + (size_t) i * *lda + order, 0, sizeof(double) * (*lda - order));
+    }
+
+    return (double*) matrix;
+}
+
+double* reserveMatrix(int order, int *lda){
+
+    void *matrix;
+
+    *lda = leadingDimension(order);
+
+    if(posix_memalign(&matrix, JRBIN_ALIGN, sizeof(double) * (size_t) order * *lda) != 0)
+        return NULL;
+
+    return (double*) matrix;
+}
+
+void touchRows(double *A, int lda, int start, int end){
+
+    memset(A + (size_t) start * lda, 0, sizeof(double) * (size_t) (end - start) * lda);
+}
+
+float* allocateFloatMatrix(int order, int *lda){
+
+    int i;
+    int perLine = JRBIN_ALIGN / sizeof(float);
+    void *matrix;
+
+    *lda = ((order + perLine - 1) / perLine) * perLine;
+
+    if(posix_memalign(&matrix, JRBIN_ALIGN, sizeof(float) * (size_t) order * *lda) != 0)
+        return NULL;
+
+    for(i = 0; i < order; i++){
+        memset((float*) matrix + (size_t) i * *lda + order, 0, sizeof(float) * (*lda - order));
+    }
+
+    return (float*) matrix;
+}
+
+void layoutBinaryHeader(BinaryHeader *header, int order, int rowTest,
+        double error, int iteMax, uint32_t flags){
+
+    uint64_t vectorSize;
+
+    memset(header, 0, sizeof(BinaryHeader));
+    memcpy(header->magic, JRBIN_MAGIC, sizeof(header->magic));
+
+    header->version = JRBIN_VERSION;
+    header->flags = flags;
+    header->order = order;
+    header->rowTest = rowTest;
+    header->iteMax = iteMax;
+    header->error = error;
+    header->lda = leadingDimension(order);
+
+    // Each section is padded to lda doubles, so they all start aligned
+    vectorSize = (uint64_t) header->lda * sizeof(double);
+
+    header->aOffset = ((sizeof(BinaryHeader) + JRBIN_ALIGN - 1) / JRBIN_ALIGN) * JRBIN_ALIGN;
+    header->bOffset = header->aOffset + vectorSize * order;
+    header->rowOffset = header->bOffset + vectorSize;
+    header->fileSize = header->rowOffset;
+
+    if(flags & JRBIN_PREPARED)
+        header->fileSize += vectorSize;
+}
+
+int isBinaryMatrix(FILE *file){
+
+    char magic[8];
+    long position = ftell(file);
+    size_t n = fread(magic, 1, sizeof(magic), file);
+
+    fseek(file, position, SEEK_SET);
+
+    return n == sizeof(magic) && memcmp(magic, JRBIN_MAGIC, sizeof(magic)) == 0;
+}
+
+/**
+ * Whether length bytes from offset lie inside a mapping of size bytes
+ */
+static int regionFits(uint64_t offset, uint64_t length, size_t size){
+
+    return offset <= size && length <= size - offset;
+}
+
+int mapBinaryMatrix(int fd, int writable, MappedMatrix *matrix){
+
+    struct stat st;
+    const BinaryHeader *header;
+    int protection = PROT_READ;
+    uint64_t vectorSize;
+
+    memset(matrix, 0, sizeof(MappedMatrix));
+
+    if(fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(BinaryHeader)){
+        fprintf(stderr, "Binary matrix: file is too small\n");
+        return 1;
+    }
+
+    if(writable)
+        protection |= PROT_WRITE;
+
+    matrix->size = st.st_size;
+    matrix->base = mmap(NULL, matrix->size, protection, MAP_PRIVATE, fd, 0);
+    if(matrix->base == MAP_FAILED){
+        perror("Binary matrix: mmap");
+        matrix->base = NULL;
+        return 1;
+    }
+
+    header = (const BinaryHeader*) matrix->base;
+    if(memcmp(header->magic, JRBIN_MAGIC, sizeof(header->magic)) != 0 ||
+            header->version != JRBIN_VERSION){
+        fprintf(stderr, "Binary matrix: unknown magic or version\n");
+        unmapBinaryMatrix(matrix);
+        return 1;
+    }
+
+    if(header->order <= 0 || header->lda < header->order ||
+            header->fileSize > matrix->size ||
+            header->rowTest < 0 || header->rowTest >= header->order){
+        fprintf(stderr, "Binary matrix: corrupted header\n");
+        unmapBinaryMatrix(matrix);
+        return 1;
+    }
+
+    // The offsets come from the file too, every section has to be mapped
+    vectorSize = (uint64_t) header->lda * sizeof(double);
+    if(!regionFits(header->aOffset, vectorSize * header->order, matrix->size) ||
+            !regionFits(header->bOffset, vectorSize, matrix->size) ||
+            ((header->flags & JRBIN_PREPARED) && !regionFits(header->rowOffset, vectorSize, matrix->size))){
+        fprintf(stderr, "Binary matrix: truncated or corrupted file\n");
+        unmapBinaryMatrix(matrix);
+        return 1;
+    }
+
+    // The matrix is streamed once per iteration, let the kernel read ahead
+    madvise(matrix->base, matrix->size, MADV_SEQUENTIAL);
+
+    matrix->header = header;
+    matrix->A = (double*) ((char*) matrix->base + header->aOffset);
+    matrix->b = (double*) ((char*) matrix->base + header->bOffset);
+    matrix->row = NULL;
+    if(header->flags & JRBIN_PREPARED)
+        matrix->row = (double*) ((char*) matrix->base + header->rowOffset);
+
+    return 0;
+}
+
+void unmapBinaryMatrix(MappedMatrix *matrix){
+
+    if(matrix->base != NULL)
+        munmap(matrix->base, matrix->size);
+
+    memset(matrix, 0, sizeof(MappedMatrix));
+}
+
+int writeBinaryHeader(FILE *file, const BinaryHeader *header){
+
+    static const char zeros[JRBIN_ALIGN];
+    size_t padding = header->aOffset - sizeof(BinaryHeader);
+
+    if(fwrite(header, sizeof(BinaryHeader), 1, file) != 1)
+        return 1;
+
+    if(padding > 0 && fwrite(zeros, 1, padding, file) != padding)
+        return 1;
+
+    return 0;
+}
+
+int writeBinaryVector(FILE *file, const BinaryHeader *header, const double *values){
+
+    static const double zeros[JRBIN_ALIGN / sizeof(double)];
+    size_t padding = header->lda - header->order;
+
+    if(fwrite(values, sizeof(double), header->order, file) != (size_t) header->order)
+        return 1;
+
+    if(padding > 0 && fwrite(zeros, sizeof(double), padding, file) != padding)
+        return 1;
+
+    return 0;
+}
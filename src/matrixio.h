@@ -0,0 +1,137 @@
+#ifndef MATRIXIO_H
+#define MATRIXIO_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * Binary container for a Jacobi-Richardson problem
+ *
+ * The layout is designed so the solvers can mmap the file and iterate on it
+ * directly:
+ *
+ *   [BinaryHeader][pad to aOffset][A rows][b][original row J_ROW_TEST]
+ *
+ * Every section is padded the same way as the rows of A.
+ *
+ * Every row of A is lda doubles long (lda is J_ORDER rounded up to a whole
+ * number of 64-byte cache lines) and starts on a 64-byte boundary. All the
+ * values are stored in host byte order, files written on a machine with a
+ * different endianness are rejected by the magic/version check.
+ *
+ * When JRBIN_PREPARED is set, A and b have already been divided by the main
+ * diagonal (see prepareMatrices) and the untouched row J_ROW_TEST is stored
+ * after b so the result can still be tested.
+ */
+
+#define JRBIN_MAGIC "JRMATRIX"
+#define JRBIN_VERSION 1
+#define JRBIN_ALIGN 64
+
+// A and b were already divided by the main diagonal
+#define JRBIN_PREPARED 0x1
+
+typedef struct {
+
+    char magic[8];
+    uint32_t version;
+    uint32_t flags;
+    int32_t order;
+    int32_t rowTest;
+    int32_t iteMax;
+    int32_t lda;
+    double error;
+    double testedB;
+    uint64_t aOffset;
+    uint64_t bOffset;
+    uint64_t rowOffset;
+    uint64_t fileSize;
+
+} BinaryHeader;
+
+/**
+ * A binary matrix file mapped in memory
+ * A, b and row point straight into the mapping
+ */
+typedef struct {
+
+    void *base;
+    size_t size;
+    const BinaryHeader *header;
+    double *A;
+    double *b;
+    double *row;
+
+} MappedMatrix;
+
+/**
+ * Leading dimension (in doubles) used for a matrix of the given order: the
+ * order rounded up to a whole number of cache lines
+ */
+int leadingDimension(int order);
+
+/**
+ * Allocate a J_ORDER x lda matrix in a single cache-line-aligned block, lda
+ * is set to leadingDimension(order). The padding columns are zeroed.
+ * Returns NULL if the allocation fails.
+ */
+double* allocateMatrix(int order, int *lda);
+
+/**
+ * Same as allocateMatrix but nothing is written, not even the padding, so
+ * the pages are placed by whoever touches them first (see topology.h). Every
+ * row has to go through touchRows before it is used
+ */
+double* reserveMatrix(int order, int *lda);
+
+/**
+ * Zero the rows [start, end) of a matrix, padding included
+ */
+void touchRows(double *A, int lda, int start, int end);
+
+/**
+ * Same as allocateMatrix for a matrix stored as float, lda is the order
+ * rounded up to a whole number of cache lines of floats
+ */
+float* allocateFloatMatrix(int order, int *lda);
+
+/**
+ * Fill the header fields and compute the offsets of every section
+ */
+void layoutBinaryHeader(BinaryHeader *header, int order, int rowTest,
+        double error, int iteMax, uint32_t flags);
+
+/**
+ * Check whether the file starts with the binary magic. The file position is
+ * restored before returning.
+ */
+int isBinaryMatrix(FILE *file);
+
+/**
+ * Map the binary matrix stored in the file descriptor
+ *
+ * writable: when set the mapping is private and writable, so the caller can
+ * scale the matrix in place without touching the file (copy-on-write)
+ *
+ * Returns 0 on success, 1 on failure (a message is printed to stderr)
+ */
+int mapBinaryMatrix(int fd, int writable, MappedMatrix *matrix);
+
+/**
+ * Release a mapping created by mapBinaryMatrix
+ */
+void unmapBinaryMatrix(MappedMatrix *matrix);
+
+/**
+ * Write the header followed by the padding up to the first row of A
+ */
+int writeBinaryHeader(FILE *file, const BinaryHeader *header);
+
+/**
+ * Write J_ORDER values padded to lda. Used for every row of A, for b and for
+ * the original tested row, in this order
+ */
+int writeBinaryVector(FILE *file, const BinaryHeader *header, const double *values);
+
+#endif
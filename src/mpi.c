@@ -0,0 +1,522 @@
+#include <stdio.h>
+#include <time.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mpi.h>
+
+#include "matrixio.h"
+#include "textparse.h"
+#include "kernels.h"
+#include "options.h"
+#include "sparse.h"
+
+/**
+ * Distributed memory Jacobi-Richardson
+ *
+ * Every rank keeps a block of consecutive rows of Matrix A, so a system
+ * larger than the memory of a single host can be split over several of them.
+ * Each iteration a rank computes its block of x(k+1), the blocks are
+ * exchanged with an allgather so every rank has the whole x for the next one
+ * and the max error of the blocks is reduced over all the ranks.
+ *
+ * With --overlap the exchange is non-blocking: while the blocks of the other
+ * ranks are still on the way, each rank multiplies its rows by its own block
+ * of x, which it already has, and only waits before the rest of the columns.
+ */
+
+/**
+ * Structure that hold all the information about the problem, as seen by one
+ * rank
+ * J_ORDER : Matrix Order
+ * J_ROW_TEST: Row that will be used to test the result
+ * J_ERROR: Error value acceptable
+ * J_ITE_MAX: Max number of iterations allowed
+ * start/end: Rows of Matrix A kept by this rank
+ * *Ma: Rows [start, end) of Matrix A, row i starts at Ma + (i - start) * lda
+ * lda: Leading dimension of Matrix A, J_ORDER padded to a cache line
+ * *Mb: Pointer to the whole array B
+ * *testedRow: Original row J_ROW_TEST, only on the rank that keeps it
+ * testedB: Original value of Array B at J_ROW_TEST
+ * mapped: Binary file backing Ma and Mb, if the input was a binary matrix
+ * prepared: Ma and Mb were already divided by the main diagonal
+ */
+typedef struct {
+
+    int J_ORDER;
+    int J_ROW_TEST;
+    double J_ERROR;
+    int J_ITE_MAX;
+    int start;
+    int end;
+    double *Ma;
+    int lda;
+    double *Mb;
+    double *testedRow;
+    double testedB;
+    MappedMatrix mapped;
+    int prepared;
+
+} Data;
+
+// Only written by rank 0
+FILE *outputFile;
+
+// Dot product kernel picked at runtime for this CPU
+const Kernel *kernel;
+
+// Cache blocking of the dense sweep, sized for this CPU
+Blocking blocking;
+
+// Command line options
+Options options;
+
+// This process and the number of processes
+int rank;
+int ranks;
+
+// Rows of every rank, the counts and displacements of the allgather
+int *rowCounts;
+int *rowStarts;
+
+double average = 0;
+int iterations = 0;
+
+/**
+ * Split J_ORDER rows in ranks blocks of consecutive rows
+ */
+void partitionRows(Data *data);
+
+/**
+ * Read the rows of this rank from a text or binary matrix
+ */
+int readFromFile(FILE* file, Data *data);
+
+/**
+ * Parse the text matrix keeping only the rows of this rank (see textparse.h)
+ */
+int readFromText(FILE* file, Data *data);
+
+/**
+ * Map a binary matrix (see matrixio.h). Only the pages of the rows of this
+ * rank are ever read
+ */
+int readFromBinary(FILE* file, Data *data);
+
+/**
+ * Divide the rows of this rank and their values of Array B by the main
+ * diagonal, see prepareMatrices in main.c
+ */
+void prepareMatrices(Data *data);
+
+/**
+ * The iterative method itself
+ *
+ * It calculates X(k+1) = -(L* + R*)x(k) + b*, each rank its own rows,
+ * whlie the error < J_ERROR or number of iterations reached < J_ITE_MAX
+ *
+ */
+void JacobiRichardson(Data *data);
+
+/**
+ * Free all the memory allocated for the data strucute
+ *
+ */
+void freeData(Data *data);
+
+/**
+ * Main function
+ *
+ */
+int main(int argc, char* argv[]){
+
+    int i;
+    struct timespec start, loaded, prepared;
+    double loadTime = 0;
+    double prepareTime = 0;
+    int loads = 0;
+    int failed = 0;
+
+    Data *myData;
+    FILE *file;
+
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &ranks);
+
+    // if the user has not passed the file path as argument
+    if(parseOptions(argc, argv, 0, 10, &options) != 0){
+        MPI_Finalize();
+        return 1;
+    }
+
+    // Options of the library engines the ranks would otherwise ignore
+    if(options.rhsPath != NULL || options.method != METHOD_JACOBI
+            || options.precision != PRECISION_DOUBLE || options.storage == STORAGE_SPARSE
+            || options.async || options.checkpointPath != NULL || options.resume
+            || options.initialPath != NULL || options.exportPath != NULL || options.outOfCore
+            || options.tune != TUNE_OFF || options.pin || options.counters
+            || options.jsonPath != NULL || options.csvPath != NULL){
+        if(rank == 0)
+            fprintf(stderr, "The MPI solver only runs dense Jacobi-Richardson with a single right-hand side\n");
+        MPI_Finalize();
+        return 1;
+    }
+
+    if(rank == 0){
+        outputFile = fopen(options.outputPath, "w");
+        if(outputFile == NULL)
+            fprintf(stderr, "Could not open the output file %s\n", options.outputPath);
+        failed = outputFile == NULL;
+    }
+
+    // Every rank stops, not only the one that writes the output
+    MPI_Bcast(&failed, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    if(failed){
+        MPI_Finalize();
+        return 1;
+    }
+
+    kernel = selectKernel();
+    detectBlocking(&blocking);
+
+    rowCounts = (int*) malloc(sizeof(int) * ranks);
+    rowStarts = (int*) malloc(sizeof(int) * ranks);
+
+    for(i = 0; i < options.runs; i++){
+
+        // Read data from file, only once when the matrix is reused
+        if(i == 0 || !options.loadOnce){
+            MPI_Barrier(MPI_COMM_WORLD);
+            clock_gettime(CLOCK_MONOTONIC, &start);
+
+            myData = (Data*) malloc (sizeof(Data));
+            file = fopen(options.matrixPath, "r");
+            if(file == NULL || readFromFile(file, myData) != 0)
+                MPI_Abort(MPI_COMM_WORLD, 1);
+
+            MPI_Barrier(MPI_COMM_WORLD);
+            clock_gettime(CLOCK_MONOTONIC, &loaded);
+            prepareMatrices(myData);
+            MPI_Barrier(MPI_COMM_WORLD);
+            clock_gettime(CLOCK_MONOTONIC, &prepared);
+
+            loadTime = loadTime + elapsedTime(start, loaded);
+            prepareTime = prepareTime + elapsedTime(loaded, prepared);
+            loads++;
+
+            if(loads == 1 && rank == 0){
+                fprintf(outputFile, "Kernel: %s\n", kernel->name);
+                fprintf(outputFile, "Blocking: %d columns (L1 %ldK, L2 %ldK)\n", blocking.columns,
+                        blocking.l1 / 1024, blocking.l2 / 1024);
+                fprintf(outputFile, "Ranks: %d, %d to %d rows each\n", ranks,
+                        rowCounts[0], rowCounts[ranks - 1]);
+                fprintf(outputFile, "Exchange: allgather%s\n", options.overlap ? ", overlapped" : "");
+            }
+        }
+
+        // The solve never writes to Matrix A or Array B, so the prepared data
+        // stays pristine and only the iteration state is reset
+        iterations = 0;
+        JacobiRichardson(myData);
+
+        if(!options.loadOnce || i == options.runs - 1){
+            fclose(file);
+            freeData(myData);
+        }
+    }
+
+    if(rank == 0){
+        fprintf(outputFile, "\nLoad Average: %lf\n", loadTime/loads);
+        fprintf(outputFile, "Preprocessing Average: %lf\n", prepareTime/loads);
+        fprintf(outputFile, "Average: %lf\n", average/options.runs);
+        printf("Number of Iterations: %d\n", iterations);
+        printf("Load Average: %lf\n", loadTime/loads);
+        printf("Preprocessing Average: %lf\n", prepareTime/loads);
+        printf("Time Average: %lf\n", average/options.runs);
+
+        fclose(outputFile);
+    }
+
+    free(rowCounts);
+    free(rowStarts);
+
+    MPI_Finalize();
+
+    return 0;
+}
+
+void partitionRows(Data *data){
+
+    int r;
+
+    // Same split as the OpenMP blocks, the sizes differ by one at most and
+    // the last block is the largest
+    for(r = 0; r < ranks; r++){
+        rowStarts[r] = (int) ((long) data->J_ORDER * r / ranks);
+        rowCounts[r] = (int) ((long) data->J_ORDER * (r + 1) / ranks) - rowStarts[r];
+    }
+
+    data->start = rowStarts[rank];
+    data->end = rowStarts[rank] + rowCounts[rank];
+}
+
+void prepareMatrices(Data *data){
+
+    // control variables
+    int i, j;
+    double currentDiagonal;
+    double *row;
+
+    // Binary matrices can be stored already prepared
+    if(data->prepared)
+        return;
+
+    for(i = data->start; i < data->end; i++){
+
+        row = data->Ma + (size_t) (i - data->start) * data->lda;
+        currentDiagonal = row[i];
+
+        // Divide the array B by the respective diagonal value
+        data->Mb[i] = data->Mb[i] / currentDiagonal;
+        for(j = 0; j < data->J_ORDER; j++){
+            // We divide the position by the correpondent diagonal value
+            row[j] = row[j] / currentDiagonal;
+        }
+        row[i] = 0;
+    }
+}
+
+/**
+ * Add the product of the rows of this rank by the columns [first, last) of
+ * x to lrx
+ */
+static void addColumns(Data *data, int first, int last, const double *x, double *lrx, double *partial){
+
+    int i;
+    int rows = data->end - data->start;
+
+    if(last <= first)
+        return;
+
+    multiRowDot(kernel, &blocking, data->Ma + first, data->lda, rows, x + first, last - first, partial);
+    for(i = 0; i < rows; i++){
+        lrx[i] += partial[i];
+    }
+}
+
+void JacobiRichardson(Data *data){
+
+    // Control variables
+    int i;
+    int rows = data->end - data->start;
+    double *x_current, *x_next, *temp;
+    double *lrx_result, *partial, *x_own;
+    double error = 0;
+    double localError, result, rowTest;
+    MPI_Request requests[2];
+    struct timespec start, finish;
+    double time_spent;
+
+    // The starting point is 0, every rank keeps the whole x
+    x_current = (double*) calloc(sizeof(double), data->J_ORDER);
+    x_next = (double*) calloc(sizeof(double), data->J_ORDER);
+    lrx_result = (double*) calloc(sizeof(double), rows + 1);
+    partial = (double*) calloc(sizeof(double), rows + 1);
+    x_own = (double*) calloc(sizeof(double), rows + 1);
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    do{
+
+        if(options.overlap && iterations > 0){
+            // Own block of x first, the other blocks are still arriving. x_current
+            // is the buffer of the pending gather, so the copy of the block is read
+            multiRowDot(kernel, &blocking, data->Ma + data->start, data->lda, rows,
+                    x_own, rows, lrx_result);
+
+            MPI_Waitall(2, requests, MPI_STATUSES_IGNORE);
+            if(!(error > data->J_ERROR && iterations < data->J_ITE_MAX))
+                break;
+
+            addColumns(data, 0, data->start, x_current, lrx_result, partial);
+            addColumns(data, data->end, data->J_ORDER, x_current, lrx_result, partial);
+        }
+        else{
+            multiRowDot(kernel, &blocking, data->Ma, data->lda, rows, x_current,
+                    data->J_ORDER, lrx_result);
+        }
+
+        localError = 0;
+        for(i = data->start; i < data->end; i++){
+            x_next[i] = - lrx_result[i - data->start] + data->Mb[i];
+            if(fabs((x_next[i] - x_current[i]) / x_next[i]) > localError)
+                localError = fabs((x_next[i] - x_current[i]) / x_next[i]);
+        }
+
+        // Every rank gets the blocks of the others and the global max error
+        if(options.overlap){
+            memcpy(x_own, x_next + data->start, sizeof(double) * rows);
+            MPI_Iallgatherv(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL, x_next, rowCounts, rowStarts,
+                    MPI_DOUBLE, MPI_COMM_WORLD, &requests[0]);
+            MPI_Iallreduce(&localError, &error, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD, &requests[1]);
+        }
+        else{
+            MPI_Allgatherv(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL, x_next, rowCounts, rowStarts,
+                    MPI_DOUBLE, MPI_COMM_WORLD);
+            MPI_Allreduce(&localError, &error, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+        }
+
+        temp = x_current;
+        x_current = x_next;
+        x_next = temp;
+        iterations++;
+
+    } while (options.overlap || (error > data->J_ERROR && iterations < data->J_ITE_MAX));
+
+    // Calculates the value for row J_ROW_TEST on the rank that keeps it
+    result = 0;
+    if(data->testedRow != NULL){
+        for(i = 0; i < data->J_ORDER; i++){
+            result = result + data->testedRow[i]*x_current[i];
+        }
+    }
+    MPI_Reduce(&result, &rowTest, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+
+    clock_gettime(CLOCK_MONOTONIC, &finish);
+
+    time_spent = elapsedTime(start, finish);
+    average = average + time_spent;
+
+    if(rank == 0){
+        fprintf(outputFile, "===========================================\n");
+        fprintf(outputFile, "Time Spent %lf\n" , time_spent);
+        fprintf(outputFile, "Iterations %d\n", iterations);
+        fprintf(outputFile, "RowTest: %d => [%lf] =? [%lf]\n", data->J_ROW_TEST, rowTest, data->testedB);
+    }
+
+    free(x_current);
+    free(x_next);
+    free(lrx_result);
+    free(partial);
+    free(x_own);
+}
+
+int readFromFile(FILE *file, Data *data){
+
+    memset(&data->mapped, 0, sizeof(MappedMatrix));
+    data->prepared = 0;
+    data->testedRow = NULL;
+
+    if(isMatrixMarket(file)){
+        if(rank == 0)
+            fprintf(stderr, "The MPI solver reads text or binary matrices, not Matrix Market\n");
+        return 1;
+    }
+
+    if(isBinaryMatrix(file))
+        return readFromBinary(file, data);
+
+    return readFromText(file, data);
+}
+
+int readFromText(FILE *file, Data *data){
+
+    int rows;
+    TextMatrix text;
+
+    // Mapping the file and reading data about the problem metadata. Matrix
+    // order, row used for testing purposes, acceptable error value and max
+    // number of iterations
+    if(openTextMatrix(fileno(file), &text) != 0)
+        return 1;
+
+    data->J_ORDER = text.order;
+    data->J_ROW_TEST = text.rowTest;
+    data->J_ERROR = text.error;
+    data->J_ITE_MAX = text.iteMax;
+    partitionRows(data);
+    rows = data->end - data->start;
+
+    // Allocating memory for the rows of this rank, padding zeroed
+    data->lda = leadingDimension(data->J_ORDER);
+    if(posix_memalign((void**) &data->Ma, JRBIN_ALIGN, sizeof(double) * ((size_t) rows * data->lda + 1)) != 0){
+        closeTextMatrix(&text);
+        return 1;
+    }
+    touchRows(data->Ma, data->lda, 0, rows);
+
+    // Allocating memory for B array
+    data->Mb = (double*) malloc(sizeof(double)*data->J_ORDER);
+
+    if(parseTextRows(&text, data->start, rows, data->Ma, data->lda, data->Mb, loaderThreads()) != 0){
+        closeTextMatrix(&text);
+        return 1;
+    }
+    closeTextMatrix(&text);
+
+    if(data->J_ROW_TEST >= data->start && data->J_ROW_TEST < data->end){
+        data->testedRow = (double*) malloc(sizeof(double)*data->J_ORDER);
+        memcpy(data->testedRow, data->Ma + (size_t) (data->J_ROW_TEST - data->start) * data->lda,
+                sizeof(double)*data->J_ORDER);
+    }
+
+    data->testedB = data->Mb[data->J_ROW_TEST];
+
+    return 0;
+}
+
+int readFromBinary(FILE *file, Data *data){
+
+    const BinaryHeader *header;
+
+    // The mapping is private and writable so prepareMatrices can scale the
+    // rows of this rank in place, only the pages actually written are copied
+    if(mapBinaryMatrix(fileno(file), 1, &data->mapped) != 0)
+        return 1;
+
+    header = data->mapped.header;
+
+    data->J_ORDER = header->order;
+    data->J_ROW_TEST = header->rowTest;
+    data->J_ERROR = header->error;
+    data->J_ITE_MAX = header->iteMax;
+    data->prepared = (header->flags & JRBIN_PREPARED) != 0;
+    partitionRows(data);
+
+    // Nothing is allocated, the rows live in the mapping
+    data->lda = header->lda;
+    data->Ma = data->mapped.A + (size_t) data->start * data->lda;
+    data->Mb = data->mapped.b;
+
+    // A prepared file keeps a copy of the original row used for testing
+    if(data->J_ROW_TEST >= data->start && data->J_ROW_TEST < data->end){
+        data->testedRow = (double*) malloc(sizeof(double)*data->J_ORDER);
+        if(data->prepared)
+            memcpy(data->testedRow, data->mapped.row, sizeof(double)*data->J_ORDER);
+        else
+            memcpy(data->testedRow, data->mapped.A + (size_t) data->J_ROW_TEST * data->lda,
+                    sizeof(double)*data->J_ORDER);
+    }
+
+    data->testedB = data->prepared ? header->testedB : data->Mb[data->J_ROW_TEST];
+
+    return 0;
+}
+
+void freeData(Data *data){
+
+    // A mapped matrix is released with the mapping
+    if(data->mapped.base == NULL){
+        free(data->Ma);
+        free(data->Mb);
+    }
+
+    unmapBinaryMatrix(&data->mapped);
+
+    free(data->testedRow);
+
+    // finally free the structure
+    free(data);
+}
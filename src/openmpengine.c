@@ -0,0 +1,581 @@
+#include <stdio.h>
+#include <omp.h>
+#include <time.h>
+#include <math.h>
+#include <stdlib.h>
+
+#include "solver.h"
+#include "rhs.h"
+#include "topology.h"
+#include "trace.h"
+#include "counters.h"
+
+/**
+ * OpenMP engine, the sweeps of the original openmp program. The number of
+ * threads is options.numberOfThreads when set, OMP_NUM_THREADS otherwise
+ */
+
+// CPUs the OpenMP threads are pinned to (--pin)
+static Topology topology;
+
+// Performance counters of each OpenMP thread (--counters)
+static CounterSlot *counterSlots;
+static int counterThreads;
+
+/**
+ * Start and stop the counters on every thread of the team, libgomp keeps the
+ * same threads for every parallel region
+ */
+static void beginCounters(void);
+static void endCounters(void);
+
+/**
+ * printCounters for the threads of the team
+ */
+static void reportCounters(Data *data);
+
+/**
+ * Gauss-Seidel and SOR, see relax.h. Same stop criteria and output as
+ * JacobiRichardson
+ */
+static void GaussSeidel(Data *data);
+
+/**
+ * The iterative method itself
+ *
+ * It calculates X(k+1) = -(L* + R*)x(k) + b*
+ * whlie the error < J_ERROR or number of iterations reached < J_ITE_MAX
+ *
+ */
+static void JacobiRichardson(Data *data);
+
+/**
+ * Calcuates the aboslute error
+ * E = || x_current - x_next || 
+ *
+ * The algorithm wont stop until E < J_ERROR
+ *
+ */
+static double getError(double *x_current, double *x_next, int size);
+
+/**
+ * Calculates -(L* + R*)x
+ *
+ */
+static void LRx(Data *data, double* x_current, double* lrxresult);
+
+/**
+ * Same method for several right-hand sides at once, see rhs.h. Every row of
+ * Matrix A is read once per iteration for all the active right-hand sides
+ */
+static void JacobiRichardsonMultiple(Data *data);
+
+/**
+ * Calculates (L* + R*)X for the first active columns of the interleaved X
+ *
+ */
+static void LRxMultiple(Data *data, double* x_current, int active, double* lrxresult);
+
+static void GaussSeidel(Data *data){
+
+    int i, k, c;
+    int t, threads, start, end;
+    double *x_current, *x_next, *temp;
+    double error, rowError, result;
+    struct timespec begin, finish;
+    double time_spent;
+
+    // Same starting point as JacobiRichardson
+    x_current = (double*) malloc(sizeof(double) * data->J_ORDER);
+    startIterate(data, x_current);
+    x_next = (double*) calloc(sizeof(double), data->J_ORDER);
+
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    if(options.counters)
+        beginCounters();
+    do{
+
+        error = 0;
+        if(data->sparse != NULL){
+            // One color after the other, x is updated in place
+            for(c = 0; c < data->coloring->colors; c++){
+                #pragma omp parallel for private(k, rowError) reduction(max:error)
+                for(k = data->coloring->colorStart[c]; k < data->coloring->colorStart[c + 1]; k++){
+                    rowError = relaxSparseRow(data->sparse, data->Mb, data->coloring->rows[k], data->omega, x_current);
+                    if(rowError > error)
+                        error = rowError;
+                }
+            }
+        }
+        else{
+            // Each thread sweeps its own block of rows
+            #pragma omp parallel private(t, threads, start, end) reduction(max:error)
+            {
+                threads = omp_get_num_threads();
+                t = omp_get_thread_num();
+                rowBlock(data->J_ORDER, threads, t, &start, &end);
+                error = sweepDenseBlock(kernel, data->Ma, data->lda, data->Mb, data->J_ORDER,
+                        start, end, relaxationFactor(data, threads), x_current, x_next);
+            }
+
+            temp = x_current;
+            x_current = x_next;
+            x_next = temp;
+        }
+        iterations++;
+
+    } while (error > data->J_ERROR && iterations < data->J_ITE_MAX);
+
+    result = 0;
+    for(i = 0; i < data->J_ORDER; i++){
+        result = result + data->testedRow[i]*x_current[i];
+    }
+
+    if(options.counters)
+        endCounters();
+
+    clock_gettime(CLOCK_MONOTONIC, &finish);
+
+    rowTestResult = result;
+    time_spent = elapsedTime(begin, finish);
+
+    keepSolution(data, x_current);
+    free(x_current);
+    free(x_next);
+
+    timeSpent = time_spent;
+
+    fprintf(outputFile, "===========================================\n");
+    fprintf(outputFile, "Time Spent %lf\n" , time_spent);
+    fprintf(outputFile, "Iterations %d\n", iterations);
+    fprintf(outputFile, "RowTest: %d => [%lf] =? [%lf]\n", data->J_ROW_TEST, result, data->testedB[0]);
+    if(options.counters)
+        reportCounters(data);
+}
+
+static void JacobiRichardson(Data *data){
+
+    // Control variables
+    int i;
+
+    // Current x value, initial value is 0 (or the initial guess) for sake of simplicity
+    double* x_current;
+
+    // X(k+1)
+    double* x_next;   
+
+    // X(k-1) and the weight of the Chebyshev recurrence, NULL for plain
+    // Jacobi-Richardson
+    double* x_previous = NULL;
+    double omega = 1;
+
+    // (L* + R*)x_current
+    double* lrx_result;
+
+    // Error variable
+    double error = 100;
+
+    struct timespec start, finish;
+    double time_spent;
+
+    if(options.method != METHOD_JACOBI && options.method != METHOD_CHEBYSHEV){
+        GaussSeidel(data);
+        return;
+    }
+
+    if(data->rhsCount > 1){
+        JacobiRichardsonMultiple(data);
+        return;
+    }
+
+    // Variable to keep track the number of iterations
+
+    // Allocates memory for the x values, 
+    // the starting point is 0 or the initial guess (see startIterate)
+    // final awnser will be placed at x_next
+    x_current = (double*) malloc(sizeof(double) * data->J_ORDER);
+    startIterate(data, x_current);
+    x_next = (double*) calloc(sizeof(double), data->J_ORDER);
+    lrx_result = (double*) malloc(sizeof(double) * data->J_ORDER);
+
+    if(options.method == METHOD_CHEBYSHEV){
+        x_previous = (double*) malloc(sizeof(double) * data->J_ORDER);
+        startIterate(data, x_previous);
+    }
+
+    // A resumed solve starts from the saved iterate
+    if(data->checkpoint != NULL)
+        iterations = checkpointBegin(data->checkpoint, x_current);
+
+    // The calculation is not over until the error is lesser than J_ERROR or
+    // we haven't reach the maxium number of iterations allowed
+
+    TRACE_START(omp_get_max_threads());
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if(options.counters)
+        beginCounters();
+    do{
+    
+        // Every thread records its own sweep inside LRx
+        LRx(data, x_current, lrx_result);
+
+        TRACE_BEGIN(check);
+        {
+            for(i = 0; i < data->J_ORDER; i++){
+                x_next[i] = - lrx_result[i] + data->Mb[i];  
+                // Chebyshev, the row only needs its own x(k) and x(k-1)
+                if(x_previous != NULL)
+                    x_next[i] = chebyshevRow(&data->spectrum, omega, x_next[i], x_current[i], x_previous[i]);
+            }
+        }
+        // perform the error calculus
+        error = getError(x_current, x_next, data->J_ORDER);
+        iterations++; 
+        TRACE_END(0, "check", check);
+        TRACE_COUNTER(0, "error", error);
+
+        double* temp;
+        temp = x_current;
+        x_current = x_next;
+        x_next = temp;
+
+        // The oldest iterate is the one overwritten next
+        if(x_previous != NULL){
+            x_next = x_previous;
+            x_previous = temp;
+            omega = chebyshevWeight(&data->spectrum, iterations, omega);
+        }
+
+        if(data->checkpoint != NULL)
+            checkpointIteration(data->checkpoint, x_current, iterations, error);
+
+    } while (error > data->J_ERROR && iterations < data->J_ITE_MAX);
+
+    // Calculates the value for row J_ROW_TEST
+    double result = 0;
+    for(i = 0; i < data->J_ORDER; i++){
+        result = result + data->testedRow[i]*x_current[i];  
+    }
+
+    if(options.counters)
+        endCounters();
+
+    clock_gettime(CLOCK_MONOTONIC, &finish);
+
+    rowTestResult = result;
+    time_spent = elapsedTime(start, finish);
+
+    keepSolution(data, x_current);
+    free(x_current);
+    free(x_next);
+    free(lrx_result);
+    free(x_previous);
+
+    timeSpent = time_spent;
+
+    fprintf(outputFile, "===========================================\n");
+    fprintf(outputFile, "Time Spent %lf\n" , time_spent);
+    fprintf(outputFile, "Iterations %d\n", iterations);
+    fprintf(outputFile, "RowTest: %d => [%lf] =? [%lf]\n", data->J_ROW_TEST, result, data->testedB[0]);
+    if(data->checkpoint != NULL)
+        checkpointEnd(data->checkpoint);
+    if(options.counters)
+        reportCounters(data);
+    TRACE_FINISH(openmpEngine.name);
+}
+
+
+
+static void LRx(Data *data, double* x_current, double* lrxresult){
+
+    int i;
+    int t, threads, start, end;
+
+    // Dense rows in register tiles against cache-sized blocks of x, each
+    // thread with its own block of rows like GaussSeidel
+    if(data->sparse == NULL && !data->useFloat){
+        #pragma omp parallel private(t, threads, start, end)
+        {
+            threads = omp_get_num_threads();
+            t = omp_get_thread_num();
+            TRACE_BEGIN(sweep);
+            rowBlock(data->J_ORDER, threads, t, &start, &end);
+            multiRowDot(kernel, &blocking, data->Ma + (size_t) start * data->lda, data->lda,
+                    end - start, x_current, data->J_ORDER, lrxresult + start);
+            TRACE_END(t, "sweep", sweep);
+        }
+        return;
+    }
+
+    #pragma omp parallel private(i)
+    {
+        TRACE_BEGIN(sweep);
+        // No wait, the end of the parallel region is the barrier and the
+        // span of each thread ends with its own rows
+        #pragma omp for schedule(static) nowait
+        for(i = 0; i < data->J_ORDER; i++){
+            if(data->sparse != NULL){
+                lrxresult[i] = csrRowDot(data->sparse, i, x_current);
+            }
+            else{
+                lrxresult[i] = kernel->dotFloat(data->MaFloat + (size_t) i * data->ldaFloat, x_current, data->J_ORDER);
+            }
+        }
+        TRACE_END(omp_get_thread_num(), "sweep", sweep);
+    }
+}
+
+static void JacobiRichardsonMultiple(Data *data){
+
+    int i, c, r;
+    int k = data->rhsCount;
+    int active;
+    double *x_current, *x_next, *temp;
+    double *errors;
+    double value, error, result;
+    RhsSet set;
+    struct timespec start, finish;
+    double time_spent;
+
+    // Interleaved x of every right-hand side, starting at 0
+    x_current = (double*) calloc(sizeof(double), (size_t) data->J_ORDER * k);
+    x_next = (double*) calloc(sizeof(double), (size_t) data->J_ORDER * k);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if(options.counters)
+        beginCounters();
+    rhsStart(&set, data->Mb, data->J_ORDER, k);
+
+    do{
+        active = set.active;
+        errors = set.errors;
+
+        // x_next gets (L* + R*)x_current first, then the new x
+        LRxMultiple(data, x_current, active, x_next);
+
+        for(c = 0; c < active; c++){
+            errors[c] = 0;
+        }
+
+        #pragma omp parallel for private(i, c, value, error) reduction(max:errors[:active])
+        for(i = 0; i < data->J_ORDER; i++){
+            for(c = 0; c < active; c++){
+                value = - x_next[(size_t) i * k + c] + set.b[(size_t) i * k + c];
+                x_next[(size_t) i * k + c] = value;
+
+                error = fabs((value - x_current[(size_t) i * k + c]) / value);
+                if(error > errors[c])
+                    errors[c] = error;
+            }
+        }
+        iterations++;
+
+        temp = x_current;
+        x_current = x_next;
+        x_next = temp;
+
+        // Converged right-hand sides leave the active columns
+        rhsRetire(&set, x_current, data->J_ERROR, iterations);
+
+    } while(set.active > 0 && iterations < data->J_ITE_MAX);
+
+    rhsFinish(&set, x_current, iterations);
+
+    if(options.counters)
+        endCounters();
+
+    clock_gettime(CLOCK_MONOTONIC, &finish);
+
+    time_spent = elapsedTime(start, finish);
+    timeSpent = time_spent;
+
+    fprintf(outputFile, "===========================================\n");
+    fprintf(outputFile, "Time Spent %lf\n" , time_spent);
+    fprintf(outputFile, "Iterations %d\n", iterations);
+    for(r = 0; r < k; r++){
+        result = rhsRowTest(&set, data->testedRow, r);
+        if(r == 0)
+            rowTestResult = result;
+
+        fprintf(outputFile, "RowTest: %d => [%lf] =? [%lf] (rhs %d, %d iterations)\n",
+                data->J_ROW_TEST, result, data->testedB[r], r, set.iterations[r]);
+    }
+
+    if(options.counters)
+        reportCounters(data);
+
+    rhsFree(&set);
+    free(x_current);
+    free(x_next);
+}
+
+static void LRxMultiple(Data *data, double* x_current, int active, double* lrxresult){
+
+    int i;
+    int t, threads, start, end;
+    double *row;
+    int k = data->rhsCount;
+
+    // Dense rows in the same blocks as LRx, where placeOpenmp put them
+    if(data->sparse == NULL){
+        #pragma omp parallel private(i, row, t, threads, start, end)
+        {
+            threads = omp_get_num_threads();
+            t = omp_get_thread_num();
+            rowBlock(data->J_ORDER, threads, t, &start, &end);
+            for(i = start; i < end; i++){
+                row = data->Ma + (size_t) i * data->lda;
+                kernel->multiDot(row, x_current, k, active, data->J_ORDER, lrxresult + (size_t) i * k);
+            }
+        }
+        return;
+    }
+
+    #pragma omp parallel for private(i) schedule(static)
+    for(i = 0; i < data->J_ORDER; i++){
+        csrRowMultiDot(data->sparse, i, x_current, k, active, lrxresult + (size_t) i * k);
+    }
+}
+
+static double getError(double *x_current, double *x_next, int size){
+
+    double error = 0;
+    double max = 0;
+
+    int i;
+
+    // Each thread keeps the max of its own rows, OpenMP combines them at the
+    // end of the loop
+    #pragma omp parallel for private(i, error) reduction(max:max)
+    for(i = 0; i < size; i++){
+        error = fabs((x_next[i] - x_current[i])/ x_next[i]);
+        if(error > max)
+            max = error;
+    }
+
+    return max;
+}
+
+
+static void startOpenmp(void){
+
+    if(options.numberOfThreads > 0)
+        omp_set_num_threads(options.numberOfThreads);
+
+    // libgomp keeps the same threads for every parallel region, so they are
+    // pinned once
+    if(options.pin){
+        readTopology(&topology, omp_get_max_threads());
+        placeOnFirstTouch();
+        #pragma omp parallel
+        pinThread(&topology, omp_get_thread_num());
+        printTopology(outputFile, &topology);
+    }
+
+    // Opened by each thread on its first solve
+    counterThreads = omp_get_max_threads();
+    posix_memalign((void**) &counterSlots, sizeof(CounterSlot), sizeof(CounterSlot) * counterThreads);
+    countersInit(counterSlots, counterThreads);
+}
+
+static void beginCounters(void){
+
+    #pragma omp parallel
+    {
+        if(omp_get_thread_num() < counterThreads)
+            countersBegin(&counterSlots[omp_get_thread_num()]);
+    }
+}
+
+static void endCounters(void){
+
+    #pragma omp parallel
+    {
+        if(omp_get_thread_num() < counterThreads)
+            countersEnd(&counterSlots[omp_get_thread_num()]);
+    }
+}
+
+static void reportCounters(Data *data){
+
+    int threads = omp_get_max_threads();
+
+    printCounters(counterSlots, threads < counterThreads ? threads : counterThreads, data);
+}
+
+/**
+ * Same row blocks as LRx, so each thread touches the rows it sweeps
+ */
+static void placeOpenmp(Data *data){
+
+    int t, threads, start, end;
+
+    // Same row blocks as LRx, so each row lands on the thread that sweeps it
+    #pragma omp parallel private(t, threads, start, end)
+    {
+        threads = omp_get_num_threads();
+        t = omp_get_thread_num();
+        rowBlock(data->J_ORDER, threads, t, &start, &end);
+        touchRows(data->Ma, data->lda, start, end);
+    }
+}
+
+static void prepareOpenmp(Data *data){
+
+    // control variables
+    int i, j;
+    int t, threads, start, end;
+    double currentDiagonal;
+    double *row;
+
+    // For each item in the Matrix A ... Same row blocks as LRx, so each
+    // thread scales the rows it sweeps
+    #pragma omp parallel private(i, j, row, currentDiagonal, t, threads, start, end)
+    {
+        threads = omp_get_num_threads();
+        t = omp_get_thread_num();
+        rowBlock(data->J_ORDER, threads, t, &start, &end);
+        for(i = start; i < end; i++){
+
+            row = data->Ma + (size_t) i * data->lda;
+            currentDiagonal = row[i];
+
+            for(j = 0; j < data->rhsCount; j++){
+                data->Mb[(size_t) i * data->rhsCount + j] = data->Mb[(size_t) i * data->rhsCount + j] / currentDiagonal;
+            }
+            for(j = 0; j < data->J_ORDER; j++){
+                // We divide the position by the correpondent diagonal value
+                row[j] = row[j] / currentDiagonal;
+            }
+            // Divide the array B by the respective diagonal value
+            row[i] = 0;
+        }
+    }
+}
+
+static int threadsOpenmp(void){
+
+    return omp_get_max_threads();
+}
+
+/**
+ * Only fewer threads than at start, the pinned ones are reused
+ */
+static void resizeOpenmp(int numberOfThreads){
+
+    omp_set_num_threads(numberOfThreads);
+}
+
+static void stopOpenmp(void){
+
+    countersClose(counterSlots, counterThreads);
+    free(counterSlots);
+
+    if(options.pin)
+        freeTopology(&topology);
+}
+
+const Engine openmpEngine = {
+    "openmp", startOpenmp, placeOpenmp, prepareOpenmp, JacobiRichardson,
+    threadsOpenmp, resizeOpenmp, stopOpenmp
+};
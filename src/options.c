@@ -0,0 +1,323 @@
+#include <stdio.h>
+#include <time.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+
+#include "options.h"
+
+static void printUsage(const char *program, int needsThreads){
+
+    printf("Invalid number of arguments: %s matrix.txt outputFile%s [options]\n",
+            program, needsThreads ? " THREADS_NUMBER" : "");
+    printf("  -n, --runs N       number of timed solves\n");
+    printf("  -l, --load-once    read and prepare the matrix once for all the solves\n");
+    printf("  --warmup N         untimed solves before the timed ones (0)\n");
+    printf("  --json FILE        append the statistics of the solves as a JSON line\n");
+    printf("  --csv FILE         append the statistics of the solves as a CSV row\n");
+    printf("  --storage MODE     auto, dense or sparse (CSR) Matrix A\n");
+    printf("  --density D        densest matrix stored as sparse by auto (0.1)\n");
+    printf("  --rhs FILE         one or more right-hand sides replacing Array B\n");
+    printf("  --row-test R       J_ROW_TEST of a Matrix Market input (0)\n");
+    printf("  --error E          J_ERROR of a Matrix Market input (0.001)\n");
+    printf("  --max-iterations N J_ITE_MAX of a Matrix Market input (20000)\n");
+    printf("  --precision MODE   double, mixed (float Matrix A) or check (compare both)\n");
+    printf("  --method M         jacobi, gauss-seidel, sor or chebyshev\n");
+    printf("  --omega W          relaxation factor of sor, estimated when not given\n");
+    printf("  --engine E         auto, serial, pthreads or openmp\n");
+    printf("  -t, --threads N    threads of the pthreads and openmp engines\n");
+    printf("  --partition P      rows per thread: balanced or aligned (cache lines of x)\n");
+    printf("  --tune[=force]     pick kernel, threads and partition by timed trials, cached\n");
+    printf("  --async            pthreads: barrier-free Jacobi-Richardson, x updated in place\n");
+    printf("  --barrier KIND     pthreads: auto, spin or pthread\n");
+    printf("  --pin              pin each thread to a CPU and place its rows on its node\n");
+    printf("  --counters         report the perf_event_open counters of every thread\n");
+    printf("  --out-of-core      stream Matrix A from a prepared binary every iteration\n");
+    printf("  --stream-block MB  size of each block read by --out-of-core (64)\n");
+    printf("  --checkpoint FILE  save x and the errors to FILE during the solve\n");
+    printf("  --checkpoint-every N  iterations between two checkpoints (1000)\n");
+    printf("  --resume           continue from the --checkpoint file if there is one\n");
+    printf("  --initial FILE     start from the x in FILE instead of 0\n");
+    printf("  --export FILE      write the x of the last solve to FILE\n");
+    printf("  --overlap          MPI solver: overlap the exchange of x with the sweep\n");
+}
+
+int parseOptions(int argc, char *argv[], int needsThreads, int defaultRuns, Options *options){
+
+    int option;
+    int positional;
+    int threads;
+    static const struct option longOptions[] = {
+        { "runs", required_argument, NULL, 'n' },
+        { "load-once", no_argument, NULL, 'l' },
+        { "storage", required_argument, NULL, 's' },
+        { "density", required_argument, NULL, 'd' },
+        { "rhs", required_argument, NULL, 'b' },
+        { "row-test", required_argument, NULL, 'r' },
+        { "error", required_argument, NULL, 'e' },
+        { "max-iterations", required_argument, NULL, 'm' },
+        { "precision", required_argument, NULL, 'p' },
+        { "method", required_argument, NULL, 'M' },
+        { "omega", required_argument, NULL, 'w' },
+        { "async", no_argument, NULL, 'a' },
+        { "barrier", required_argument, NULL, 'B' },
+        { "pin", no_argument, NULL, 'P' },
+        { "overlap", no_argument, NULL, 'o' },
+        { "engine", required_argument, NULL, 'E' },
+        { "threads", required_argument, NULL, 't' },
+        { "partition", required_argument, NULL, 'D' },
+        { "tune", optional_argument, NULL, 'T' },
+        { "warmup", required_argument, NULL, 'W' },
+        { "json", required_argument, NULL, 'J' },
+        { "csv", required_argument, NULL, 'C' },
+        { "counters", no_argument, NULL, 'k' },
+        { "out-of-core", no_argument, NULL, 'O' },
+        { "stream-block", required_argument, NULL, 'S' },
+        { "checkpoint", required_argument, NULL, 'K' },
+        { "checkpoint-every", required_argument, NULL, 'I' },
+        { "resume", no_argument, NULL, 'R' },
+        { "initial", required_argument, NULL, 'X' },
+        { "export", required_argument, NULL, 'x' },
+        { NULL, 0, NULL, 0 }
+    };
+
+    memset(options, 0, sizeof(Options));
+    options->runs = defaultRuns;
+    options->storage = STORAGE_AUTO;
+    options->densityThreshold = 0.1;
+    options->error = 0.001;
+    options->iteMax = 20000;
+    options->streamBlock = 64;
+    options->checkpointEvery = 1000;
+
+    while((option = getopt_long(argc, argv, "n:lt:", longOptions, NULL)) != -1){
+        switch(option){
+            case 'n':
+                options->runs = atoi(optarg);
+                break;
+            case 'l':
+                options->loadOnce = 1;
+                break;
+            case 's':
+                if(strcmp(optarg, "dense") == 0)
+                    options->storage = STORAGE_DENSE;
+                else if(strcmp(optarg, "sparse") == 0)
+                    options->storage = STORAGE_SPARSE;
+                else if(strcmp(optarg, "auto") == 0)
+                    options->storage = STORAGE_AUTO;
+                else{
+                    printUsage(argv[0], needsThreads);
+                    return 1;
+                }
+                break;
+            case 'd':
+                options->densityThreshold = atof(optarg);
+                break;
+            case 'b':
+                options->rhsPath = optarg;
+                break;
+            case 'r':
+                options->rowTest = atoi(optarg);
+                break;
+            case 'e':
+                options->error = atof(optarg);
+                break;
+            case 'm':
+                options->iteMax = atoi(optarg);
+                break;
+            case 'p':
+                if(strcmp(optarg, "double") == 0)
+                    options->precision = PRECISION_DOUBLE;
+                else if(strcmp(optarg, "mixed") == 0)
+                    options->precision = PRECISION_MIXED;
+                else if(strcmp(optarg, "check") == 0)
+                    options->precision = PRECISION_CHECK;
+                else{
+                    printUsage(argv[0], needsThreads);
+                    return 1;
+                }
+                break;
+            case 'M':
+                if(strcmp(optarg, "jacobi") == 0)
+                    options->method = METHOD_JACOBI;
+                else if(strcmp(optarg, "gauss-seidel") == 0)
+                    options->method = METHOD_GAUSS_SEIDEL;
+                else if(strcmp(optarg, "sor") == 0)
+                    options->method = METHOD_SOR;
+                else if(strcmp(optarg, "chebyshev") == 0)
+                    options->method = METHOD_CHEBYSHEV;
+                else{
+                    printUsage(argv[0], needsThreads);
+                    return 1;
+                }
+                break;
+            case 'w':
+                options->omega = atof(optarg);
+                if(options->omega <= 0 || options->omega >= 2){
+                    fprintf(stderr, "omega must be in (0, 2)\n");
+                    return 1;
+                }
+                break;
+            case 'a':
+                options->async = 1;
+                break;
+            case 'B':
+                if(strcmp(optarg, "auto") == 0)
+                    options->barrier = BARRIER_AUTO;
+                else if(strcmp(optarg, "spin") == 0)
+                    options->barrier = BARRIER_SPIN;
+                else if(strcmp(optarg, "pthread") == 0)
+                    options->barrier = BARRIER_PTHREAD;
+                else{
+                    printUsage(argv[0], needsThreads);
+                    return 1;
+                }
+                break;
+            case 'P':
+                options->pin = 1;
+                break;
+            case 'o':
+                options->overlap = 1;
+                break;
+            case 'k':
+                options->counters = 1;
+                break;
+            case 'O':
+                options->outOfCore = 1;
+                break;
+            case 'S':
+                options->streamBlock = atoi(optarg);
+                if(options->streamBlock <= 0){
+                    printUsage(argv[0], needsThreads);
+                    return 1;
+                }
+                break;
+            case 'K':
+                options->checkpointPath = optarg;
+                break;
+            case 'I':
+                options->checkpointEvery = atoi(optarg);
+                if(options->checkpointEvery <= 0){
+                    printUsage(argv[0], needsThreads);
+                    return 1;
+                }
+                break;
+            case 'R':
+                options->resume = 1;
+                break;
+            case 'X':
+                options->initialPath = optarg;
+                break;
+            case 'x':
+                options->exportPath = optarg;
+                break;
+            case 'E':
+                if(strcmp(optarg, "auto") == 0)
+                    options->engine = ENGINE_AUTO;
+                else if(strcmp(optarg, "serial") == 0)
+                    options->engine = ENGINE_SERIAL;
+                else if(strcmp(optarg, "pthreads") == 0)
+                    options->engine = ENGINE_PTHREADS;
+                else if(strcmp(optarg, "openmp") == 0)
+                    options->engine = ENGINE_OPENMP;
+                else{
+                    printUsage(argv[0], needsThreads);
+                    return 1;
+                }
+                break;
+            case 'D':
+                if(strcmp(optarg, "balanced") == 0)
+                    options->partition = PARTITION_BALANCED;
+                else if(strcmp(optarg, "aligned") == 0)
+                    options->partition = PARTITION_ALIGNED;
+                else{
+                    printUsage(argv[0], needsThreads);
+                    return 1;
+                }
+                break;
+            case 'T':
+                if(optarg == NULL)
+                    options->tune = TUNE_ON;
+                else if(strcmp(optarg, "force") == 0)
+                    options->tune = TUNE_FORCE;
+                else{
+                    printUsage(argv[0], needsThreads);
+                    return 1;
+                }
+                break;
+            case 'W':
+                options->warmup = atoi(optarg);
+                if(options->warmup < 0){
+                    printUsage(argv[0], needsThreads);
+                    return 1;
+                }
+                break;
+            case 'J':
+                options->jsonPath = optarg;
+                break;
+            case 'C':
+                options->csvPath = optarg;
+                break;
+            case 't':
+                options->numberOfThreads = atoi(optarg);
+                if(options->numberOfThreads <= 0){
+                    printUsage(argv[0], needsThreads);
+                    return 1;
+                }
+                break;
+            default:
+                printUsage(argv[0], needsThreads);
+                return 1;
+        }
+    }
+
+    // Anything after the expected arguments is a mistake, not ignored
+    positional = argc - optind;
+    if(positional != (needsThreads ? 3 : 2) || options->runs <= 0){
+        printUsage(argv[0], needsThreads);
+        return 1;
+    }
+
+    options->matrixPath = argv[optind];
+    options->outputPath = argv[optind + 1];
+    if(needsThreads){
+        threads = atoi(argv[optind + 2]);
+        if(threads <= 0){
+            printUsage(argv[0], needsThreads);
+            return 1;
+        }
+        if(options->numberOfThreads > 0 && options->numberOfThreads != threads){
+            fprintf(stderr, "-t %d and THREADS_NUMBER %d ask for different numbers of threads\n",
+                    options->numberOfThreads, threads);
+            return 1;
+        }
+        options->numberOfThreads = threads;
+    }
+
+    return 0;
+}
+
+int precisionAgrees(int doubleIterations, double doubleResult,
+        int mixedIterations, double mixedResult, double error){
+
+    int iterationSlack = doubleIterations / 20;
+
+    if(iterationSlack < 2)
+        iterationSlack = 2;
+
+    if(abs(mixedIterations - doubleIterations) > iterationSlack)
+        return 0;
+
+    return fabs(mixedResult - doubleResult) <= error * fabs(doubleResult);
+}
+
+double elapsedTime(struct timespec start, struct timespec finish){
+
+    double time_spent;
+
+    time_spent = (finish.tv_sec - start.tv_sec);
+    time_spent += (finish.tv_nsec - start.tv_nsec) / 1000000000.0;
+
+    return time_spent;
+}
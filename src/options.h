@@ -0,0 +1,169 @@
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+#include <time.h>
+
+#include "barrier.h"
+
+// Symbols exported by the shared solver library (see jacobi.h)
+#ifndef JR_API
+#define JR_API __attribute__((visibility("default")))
+#endif
+
+/**
+ * Command line shared by the solvers
+ *
+ *   ./main matrix.txt outputFile [options]
+ *   ./openmp matrix.txt outputFile [options]
+ *   ./parallel matrix.txt outputFile THREADS_NUMBER [options]
+ *   mpirun -np N ./mpi matrix.txt outputFile [options]
+ *
+ * matrixPath/outputPath: Positional arguments
+ * numberOfThreads: Threads of the pthreads and OpenMP engines, the positional
+ * argument of the pthread solver or -t, --threads (both must agree when given
+ * together). 0 uses every processor (OMP_NUM_THREADS for OpenMP)
+ * runs: Number of timed solves (-n, --runs)
+ * loadOnce: Read and prepare the matrix once and reuse it for every solve
+ * (-l, --load-once)
+ * warmup: Untimed solves before the timed ones (--warmup)
+ * jsonPath/csvPath: Files the statistics of the timed solves are appended
+ * to, NULL for none (--json, --csv)
+ * storage: Dense or sparse (CSR) Matrix A (--storage). STORAGE_AUTO picks
+ * sparse when the density of A is below densityThreshold (--density)
+ * rhsPath: Right-hand sides replacing Array B (--rhs), a Matrix Market input
+ * without it uses A * 1
+ * rowTest/error/iteMax: J_ROW_TEST, J_ERROR and J_ITE_MAX of a Matrix Market
+ * input, which has no metadata (--row-test, --error, --max-iterations)
+ * precision: Matrix A stored as double, or as float with double x, b and
+ * accumulators (--precision). PRECISION_CHECK solves both ways and compares
+ * method: Iteration used by the solve (--method), METHOD_CHEBYSHEV is
+ * Jacobi-Richardson with Chebyshev acceleration (see chebyshev.h)
+ * omega: Relaxation factor of METHOD_SOR (--omega), 0 estimates it
+ * async: Barrier-free Jacobi-Richardson, pthreads engine only (--async)
+ * barrier: Barrier of the pthreads engine (--barrier)
+ * pin: Pin every thread to a CPU and let each one first touch and scale its
+ * own rows of Matrix A (--pin), see topology.h
+ * counters: Read the performance counters of every thread around the
+ * iteration loop and report them after each solve (--counters), see
+ * counters.h
+ * outOfCore: Read the rows of a prepared binary Matrix A from the file in
+ * blocks every iteration instead of keeping them in memory (--out-of-core),
+ * see stream.h
+ * streamBlock: Megabytes per block of outOfCore (--stream-block)
+ * checkpointPath: File the iterate is saved to every checkpointEvery
+ * iterations (--checkpoint, --checkpoint-every), see checkpoint.h
+ * resume: Start from the iterate in checkpointPath (--resume)
+ * initialPath: Initial guess of every solve (--initial), x = 0 without it
+ * exportPath: File the x of the last solve is written to (--export), in the
+ * format --initial reads
+ * overlap: MPI solver only, start the sweep on the local block of x while
+ * the rest of it is still being exchanged (--overlap)
+ * engine: Engine running the solves (--engine), ENGINE_DEFAULT leaves it to
+ * the program
+ * partition: How the rows are split between the threads (--partition):
+ * PARTITION_BALANCED gives each thread the same number of rows, one more
+ * for some of them, PARTITION_ALIGNED starts every block at a multiple of 8
+ * rows so no two threads write to the same cache line of x
+ * tune: Pick the kernel, threads and partition from short timed trials
+ * (--tune), kept per order and host in the tuning cache (see tune.h).
+ * TUNE_FORCE runs the trials even if the cache has an entry (--tune=force)
+ */
+typedef enum {
+    STORAGE_AUTO,
+    STORAGE_DENSE,
+    STORAGE_SPARSE
+} Storage;
+
+typedef enum {
+    PRECISION_DOUBLE,
+    PRECISION_MIXED,
+    PRECISION_CHECK
+} Precision;
+
+typedef enum {
+    METHOD_JACOBI,
+    METHOD_GAUSS_SEIDEL,
+    METHOD_SOR,
+    METHOD_CHEBYSHEV
+} Method;
+
+typedef enum {
+    ENGINE_DEFAULT,
+    ENGINE_AUTO,
+    ENGINE_SERIAL,
+    ENGINE_PTHREADS,
+    ENGINE_OPENMP
+} EngineKind;
+
+typedef enum {
+    PARTITION_BALANCED,
+    PARTITION_ALIGNED
+} Partition;
+
+typedef enum {
+    TUNE_OFF,
+    TUNE_ON,
+    TUNE_FORCE
+} Tune;
+
+typedef struct {
+
+    const char *matrixPath;
+    const char *outputPath;
+    int numberOfThreads;
+    int runs;
+    int loadOnce;
+    int warmup;
+    const char *jsonPath;
+    const char *csvPath;
+    Storage storage;
+    double densityThreshold;
+    const char *rhsPath;
+    int rowTest;
+    double error;
+    int iteMax;
+    Precision precision;
+    Method method;
+    double omega;
+    int async;
+    BarrierKind barrier;
+    int pin;
+    int overlap;
+    int counters;
+    int outOfCore;
+    int streamBlock;
+    const char *checkpointPath;
+    int checkpointEvery;
+    int resume;
+    const char *initialPath;
+    const char *exportPath;
+    EngineKind engine;
+    Partition partition;
+    Tune tune;
+
+} Options;
+
+/**
+ * Parse the command line. Options may appear anywhere.
+ *
+ * needsThreads: THREADS_NUMBER is a required positional argument
+ * defaultRuns: Number of solves when --runs is not given
+ *
+ * Returns 0 on success, 1 after printing the usage
+ */
+JR_API int parseOptions(int argc, char *argv[], int needsThreads, int defaultRuns, Options *options);
+
+/**
+ * Whether a mixed precision solve matches the double one: the iterations
+ * may differ by 5% (at least 2) and the RowTest values by J_ERROR, relative
+ * to the double value
+ */
+int precisionAgrees(int doubleIterations, double doubleResult,
+        int mixedIterations, double mixedResult, double error);
+
+/**
+ * Seconds elapsed between two clock_gettime readings
+ */
+JR_API double elapsedTime(struct timespec start, struct timespec finish);
+
+#endif
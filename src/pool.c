@@ -0,0 +1,111 @@
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "pool.h"
+
+/**
+ * Argument of each worker: the pool and its index
+ */
+typedef struct {
+
+    ThreadPool *pool;
+    int index;
+
+} PoolWorker;
+
+static void* poolWorker(void *rawWorker){
+
+    PoolWorker *worker = (PoolWorker*) rawWorker;
+    ThreadPool *pool = worker->pool;
+    unsigned long seen = 0;
+    void* (*task)(void*);
+    void *arg;
+
+    for(;;){
+        // Parked until a new job (or the shutdown) is published
+        pthread_mutex_lock(&pool->mutex);
+        while(pool->generation == seen && !pool->shutdown)
+            pthread_cond_wait(&pool->wake, &pool->mutex);
+
+        if(pool->shutdown){
+            pthread_mutex_unlock(&pool->mutex);
+            break;
+        }
+
+        seen = pool->generation;
+        task = pool->task;
+        arg = pool->args + worker->index * pool->argSize;
+        pthread_mutex_unlock(&pool->mutex);
+
+        task(arg);
+
+        pthread_mutex_lock(&pool->mutex);
+        pool->pending--;
+        if(pool->pending == 0)
+            pthread_cond_signal(&pool->done);
+        pthread_mutex_unlock(&pool->mutex);
+    }
+
+    free(worker);
+
+    return NULL;
+}
+
+ThreadPool* poolCreate(int numberOfThreads){
+
+    int i;
+    PoolWorker *worker;
+    ThreadPool *pool = (ThreadPool*) calloc(1, sizeof(ThreadPool));
+
+    pool->numberOfThreads = numberOfThreads;
+    pool->threads = (pthread_t*) malloc(sizeof(pthread_t) * numberOfThreads);
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+    pthread_cond_init(&pool->done, NULL);
+
+    for(i = 0; i < numberOfThreads; i++){
+        worker = (PoolWorker*) malloc(sizeof(PoolWorker));
+        worker->pool = pool;
+        worker->index = i;
+        pthread_create(&pool->threads[i], NULL, &poolWorker, worker);
+    }
+
+    return pool;
+}
+
+void poolRun(ThreadPool *pool, void* (*task)(void*), void *args, size_t argSize){
+
+    pthread_mutex_lock(&pool->mutex);
+
+    pool->task = task;
+    pool->args = (char*) args;
+    pool->argSize = argSize;
+    pool->pending = pool->numberOfThreads;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->wake);
+
+    while(pool->pending > 0)
+        pthread_cond_wait(&pool->done, &pool->mutex);
+
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+void poolDestroy(ThreadPool *pool){
+
+    int i;
+
+    pthread_mutex_lock(&pool->mutex);
+    pool->shutdown = 1;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->mutex);
+
+    for(i = 0; i < pool->numberOfThreads; i++){
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    pthread_mutex_destroy(&pool->mutex);
+    pthread_cond_destroy(&pool->wake);
+    pthread_cond_destroy(&pool->done);
+    free(pool->threads);
+    free(pool);
+}
@@ -0,0 +1,51 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <stddef.h>
+#include <pthread.h>
+
+/**
+ * Persistent pool of worker threads
+ *
+ * The workers are created once and parked on a condition variable between
+ * jobs. poolRun hands a new job to every worker and waits until all of them
+ * are done, so the same threads can run any number of solves.
+ *
+ * numberOfThreads: Number of workers
+ * generation: Incremented for every job, wakes the parked workers
+ * pending: Workers still running the current job
+ * task/args/argSize: Current job, worker i runs task(args + i * argSize)
+ */
+typedef struct {
+
+    int numberOfThreads;
+    pthread_t *threads;
+    pthread_mutex_t mutex;
+    pthread_cond_t wake;
+    pthread_cond_t done;
+    unsigned long generation;
+    int pending;
+    int shutdown;
+    void* (*task)(void*);
+    char *args;
+    size_t argSize;
+
+} ThreadPool;
+
+/**
+ * Start numberOfThreads parked workers
+ */
+ThreadPool* poolCreate(int numberOfThreads);
+
+/**
+ * Run task on every worker, worker i receives args + i * argSize, and wait
+ * until all of them return
+ */
+void poolRun(ThreadPool *pool, void* (*task)(void*), void *args, size_t argSize);
+
+/**
+ * Stop and join the workers and free the pool
+ */
+void poolDestroy(ThreadPool *pool);
+
+#endif
@@ -0,0 +1,547 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "solver.h"
+#include "textparse.h"
+#include "rhs.h"
+
+// Rows of x in a cache line, PARTITION_ALIGNED blocks start at a multiple
+#define ALIGN_ROWS 8
+
+/**
+ * First row of thread t, the blocks of consecutive threads meet there
+ */
+static int blockStart(int order, int numberOfThreads, int t){
+
+    long first;
+
+    if(t == numberOfThreads)
+        return order;
+
+    // Spread the remainder, one extra row for some of the threads
+    first = (long) order * t / numberOfThreads;
+
+    if(options.partition == PARTITION_ALIGNED){
+        first = (first + ALIGN_ROWS / 2) / ALIGN_ROWS * ALIGN_ROWS;
+        if(first > order)
+            first = order;
+    }
+
+    return (int) first;
+}
+
+void rowBlock(int order, int numberOfThreads, int t, int *start, int *end){
+
+    *start = blockStart(order, numberOfThreads, t);
+    *end = blockStart(order, numberOfThreads, t + 1);
+}
+
+void prepareMatrices(Data *data){
+
+    // Binary matrices can be stored already prepared
+    if(data->prepared)
+        return;
+
+    // Same scaling on the stored values only
+    if(data->sparse != NULL){
+        csrPrepare(data->sparse, data->Mb, data->rhsCount);
+        return;
+    }
+
+    // Each thread of the engine scales the rows it sweeps, with --pin they
+    // stay on its node
+    data->engine->prepareRows(data);
+}
+
+
+void storeAsFloat(Data *data, int keepDouble){
+
+    int i, j;
+    double *row;
+    float *floatRow;
+
+    if(data->sparse != NULL){
+        fprintf(stderr, "Mixed precision needs dense storage, solving in double\n");
+        return;
+    }
+
+    if(data->rhsCount > 1){
+        fprintf(stderr, "Mixed precision solves a single right-hand side, solving in double\n");
+        return;
+    }
+
+    if(options.method != METHOD_JACOBI && options.method != METHOD_CHEBYSHEV){
+        fprintf(stderr, "Mixed precision is only available for Jacobi-Richardson, solving in double\n");
+        return;
+    }
+
+    data->MaFloat = allocateFloatMatrix(data->J_ORDER, &data->ldaFloat);
+    if(data->MaFloat == NULL){
+        fprintf(stderr, "Not enough memory for the float Matrix A, solving in double\n");
+        return;
+    }
+
+    for(i = 0; i < data->J_ORDER; i++){
+        row = data->Ma + (size_t) i * data->lda;
+        floatRow = data->MaFloat + (size_t) i * data->ldaFloat;
+        for(j = 0; j < data->J_ORDER; j++){
+            floatRow[j] = (float) row[j];
+        }
+    }
+
+    data->useFloat = 1;
+
+    // Half the memory traffic only pays off if the double copy is gone
+    if(!keepDouble && data->mapped.base == NULL){
+        free(data->Ma);
+        data->Ma = NULL;
+    }
+}
+
+int checkPrecision(Data *data){
+
+    int doubleIterations;
+    double doubleResult;
+    int agree;
+
+    // Reference solve in double, its time is overwritten by the mixed one
+    data->useFloat = 0;
+    data->engine->solve(data);
+    doubleIterations = iterations;
+    doubleResult = rowTestResult;
+
+    data->useFloat = data->MaFloat != NULL;
+    iterations = 0;
+    data->engine->solve(data);
+
+    agree = precisionAgrees(doubleIterations, doubleResult, iterations, rowTestResult, data->J_ERROR);
+
+    fprintf(outputFile, "Precision check: %d => %d iterations, RowTest [%lf] => [%lf]: %s\n",
+            doubleIterations, iterations, doubleResult, rowTestResult, agree ? "ok" : "FAILED");
+
+    return !agree;
+}
+
+int prepareRelaxation(Data *data){
+
+    if(data->rhsCount > 1){
+        fprintf(stderr, "Gauss-Seidel and SOR solve a single right-hand side\n");
+        return 1;
+    }
+
+    // Rows of the same color can be updated at the same time
+    if(data->sparse != NULL){
+        data->coloring = (Coloring*) malloc(sizeof(Coloring));
+        colorRows(data->sparse, data->coloring);
+    }
+
+    data->omega = 1;
+    if(options.method == METHOD_SOR){
+        data->omega = options.omega;
+        if(data->omega == 0)
+            data->omega = estimateOmega(kernel, data->Ma, data->lda, data->sparse,
+                    data->coloring, data->Mb, data->J_ORDER);
+    }
+
+    return 0;
+}
+
+double relaxationFactor(Data *data, int blocks){
+
+    if(blocks > 1 && data->sparse == NULL && options.omega == 0)
+        return 1;
+
+    return data->omega;
+}
+
+int prepareChebyshev(Data *data){
+
+    if(data->rhsCount > 1){
+        fprintf(stderr, "Chebyshev acceleration solves a single right-hand side\n");
+        return 1;
+    }
+
+    estimateSpectrum(kernel, &blocking, data->Ma, data->lda, data->sparse, data->J_ORDER,
+            &data->spectrum);
+
+    return 0;
+}
+
+int readFromFile(FILE *file, Data *data){
+
+    int status;
+
+    data->rhsCount = 1;
+    data->testedB = (double*) malloc(sizeof(double));
+
+    if(options.outOfCore)
+        status = readOutOfCore(file, data);
+    else if(isMatrixMarket(file))
+        status = readFromMatrixMarket(file, data);
+    else if(isBinaryMatrix(file))
+        status = readFromBinary(file, data) || chooseStorage(data);
+    else
+        status = readFromText(file, data);
+
+    if(status != 0)
+        return status;
+
+    // A text matrix already has one, picked before Matrix A was allocated
+    if(data->engine == NULL)
+        data->engine = useEngine(data);
+
+    if(options.rhsPath == NULL)
+        return 0;
+
+    return readRightHandSides(data);
+}
+
+int readFromText(FILE *file, Data *data){
+
+    int i;
+    TextMatrix text;
+
+    // Mapping the file and reading data about the problem metadata. Matrix
+    // order, row used for testing purposes, acceptable error value and max
+    // number of iterations
+    if(openTextMatrix(fileno(file), &text) != 0)
+        return 1;
+
+    data->J_ORDER = text.order;
+    data->J_ROW_TEST = text.rowTest;
+    data->J_ERROR = text.error;
+    data->J_ITE_MAX = text.iteMax;
+    data->engine = useEngine(data);
+
+    // Allocating memory for B array
+    data->Mb = (double*) malloc(sizeof(double)*data->J_ORDER);
+
+    // Allocating memory for Matrix A, a single aligned block. With --pin the
+    // pages are left untouched and the threads of the engine touch the rows
+    // they sweep first
+    if(options.pin){
+        data->Ma = reserveMatrix(data->J_ORDER, &data->lda);
+        data->engine->placeRows(data);
+    }
+    else{
+        data->Ma = allocateMatrix(data->J_ORDER, &data->lda);
+    }
+
+    // Reading Matrix A and Array B in parallel, each value is written straight
+    // to its row
+    if(parseTextMatrix(&text, data->Ma, data->lda, data->Mb, loaderThreads()) != 0){
+        closeTextMatrix(&text);
+        return 1;
+    }
+    closeTextMatrix(&text);
+
+    data->testedRow = (double*) malloc(sizeof(double)*data->J_ORDER);
+    for(i = 0; i < data->J_ORDER; i++){
+        data->testedRow[i] = data->Ma[(size_t) data->J_ROW_TEST * data->lda + i];
+    }
+
+    data->testedB[0] = data->Mb[data->J_ROW_TEST];
+
+    return chooseStorage(data);
+}
+
+int readRightHandSides(Data *data){
+
+    int r;
+    double *values;
+
+    // Without the diagonal a new Array B can not be scaled
+    if(data->prepared){
+        fprintf(stderr, "--rhs needs a raw binary matrix (convert --raw)\n");
+        return 1;
+    }
+
+    if(readVectors(options.rhsPath, data->J_ORDER, &data->rhsCount, &values) != 0)
+        return 1;
+
+    // A mapped Array B stays in the mapping
+    if(data->mapped.base == NULL)
+        free(data->Mb);
+    data->Mb = values;
+
+    free(data->testedB);
+    data->testedB = (double*) malloc(sizeof(double) * data->rhsCount);
+    for(r = 0; r < data->rhsCount; r++){
+        data->testedB[r] = data->Mb[(size_t) data->J_ROW_TEST * data->rhsCount + r];
+    }
+
+    return 0;
+}
+
+int readFromBinary(FILE *file, Data *data){
+
+    const BinaryHeader *header;
+
+    // The mapping is private and writable so prepareMatrices can scale a raw
+    // matrix in place, only the pages actually written are copied
+    if(mapBinaryMatrix(fileno(file), 1, &data->mapped) != 0)
+        return 1;
+
+    header = data->mapped.header;
+
+    data->J_ORDER = header->order;
+    data->J_ROW_TEST = header->rowTest;
+    data->J_ERROR = header->error;
+    data->J_ITE_MAX = header->iteMax;
+    data->prepared = (header->flags & JRBIN_PREPARED) != 0;
+
+    // Nothing is allocated, the matrix lives in the mapping
+    data->Ma = data->mapped.A;
+    data->lda = header->lda;
+
+    data->Mb = data->mapped.b;
+
+    // A prepared file keeps a copy of the original row used for testing
+    data->testedRow = (double*) malloc(sizeof(double)*data->J_ORDER);
+    if(data->prepared){
+        memcpy(data->testedRow, data->mapped.row, sizeof(double)*data->J_ORDER);
+        data->testedB[0] = header->testedB;
+    }
+    else{
+        memcpy(data->testedRow, data->Ma + (size_t) data->J_ROW_TEST * data->lda, sizeof(double)*data->J_ORDER);
+        data->testedB[0] = data->Mb[data->J_ROW_TEST];
+    }
+
+    return 0;
+}
+
+int readOutOfCore(FILE *file, Data *data){
+
+    size_t blockBytes = (size_t) options.streamBlock * 1024 * 1024;
+
+    if(!isBinaryMatrix(file) || readFromBinary(file, data) != 0 || !data->prepared){
+        fprintf(stderr, "--out-of-core needs a prepared binary matrix (see convert)\n");
+        return 1;
+    }
+
+    // Matrix A stays in the file, only Array B and the tested row are read
+    // from the mapping
+    data->Ma = NULL;
+    data->stream = (StreamMatrix*) malloc(sizeof(StreamMatrix));
+    if(streamOpen(data->stream, fileno(file), data->mapped.header, blockBytes) != 0){
+        free(data->stream);
+        data->stream = NULL;
+        return 1;
+    }
+
+    return 0;
+}
+
+int readFromMatrixMarket(FILE *file, Data *data){
+
+    int i;
+    size_t k;
+    double density;
+
+    data->sparse = (CsrMatrix*) calloc(1, sizeof(CsrMatrix));
+    if(readMatrixMarket(file, data->sparse) != 0)
+        return 1;
+
+    // A Matrix Market file has no metadata, it comes from the command line
+    data->J_ORDER = data->sparse->order;
+    data->J_ROW_TEST = options.rowTest;
+    data->J_ERROR = options.error;
+    data->J_ITE_MAX = options.iteMax;
+    data->Ma = NULL;
+    data->lda = 0;
+
+    if(data->J_ROW_TEST < 0 || data->J_ROW_TEST >= data->J_ORDER){
+        fprintf(stderr, "Invalid J_ROW_TEST %d for order %d\n", data->J_ROW_TEST, data->J_ORDER);
+        return 1;
+    }
+
+    // Array B is A * 1 so the answer is all ones, unless --rhs replaces it
+    data->Mb = (double*) malloc(sizeof(double)*data->J_ORDER);
+    for(i = 0; i < data->J_ORDER; i++){
+        data->Mb[i] = 0;
+        for(k = data->sparse->rowStart[i]; k < data->sparse->rowStart[i + 1]; k++){
+            data->Mb[i] = data->Mb[i] + data->sparse->values[k];
+        }
+    }
+
+    data->testedRow = (double*) malloc(sizeof(double)*data->J_ORDER);
+    csrRow(data->sparse, data->J_ROW_TEST, data->testedRow);
+    data->testedB[0] = data->Mb[data->J_ROW_TEST];
+
+    // Dense enough to be worth expanding
+    density = (double) data->sparse->nnz / ((double) data->J_ORDER * data->J_ORDER);
+    if(options.storage == STORAGE_DENSE ||
+            (options.storage == STORAGE_AUTO && density > options.densityThreshold)){
+        data->Ma = csrToDense(data->sparse, &data->lda);
+        freeCsr(data->sparse);
+        free(data->sparse);
+        data->sparse = NULL;
+    }
+
+    return 0;
+}
+
+int chooseStorage(Data *data){
+
+    size_t nnz;
+    double density;
+
+    if(options.storage == STORAGE_DENSE)
+        return 0;
+
+    nnz = countNonZeros(data->Ma, data->lda, data->J_ORDER);
+    density = (double) nnz / ((double) data->J_ORDER * data->J_ORDER);
+    if(options.storage == STORAGE_AUTO && density > options.densityThreshold)
+        return 0;
+
+    data->sparse = (CsrMatrix*) malloc(sizeof(CsrMatrix));
+    denseToCsr(data->Ma, data->lda, data->J_ORDER, data->sparse);
+
+    // The dense matrix is no longer needed, a mapped one stays in the mapping
+    // with Array B
+    if(data->mapped.base == NULL)
+        free(data->Ma);
+    data->Ma = NULL;
+
+    return 0;
+}
+
+void startIterate(Data *data, double *x){
+
+    if(data->initial != NULL)
+        memcpy(x, data->initial, sizeof(double) * data->J_ORDER);
+    else
+        memset(x, 0, sizeof(double) * data->J_ORDER);
+}
+
+void keepSolution(Data *data, const double *x){
+
+    if(data->solution == NULL)
+        data->solution = (double*) malloc(sizeof(double) * data->J_ORDER);
+
+    memcpy(data->solution, x, sizeof(double) * data->J_ORDER);
+}
+
+const char* storageName(Data *data){
+
+    if(data->sparse != NULL)
+        return "sparse";
+
+    if(data->stream != NULL)
+        return "out-of-core";
+
+    return "dense";
+}
+
+void printStorage(Data *data){
+
+    if(data->sparse != NULL)
+        fprintf(outputFile, "Storage: sparse (%zu non-zeros off the diagonal)\n", data->sparse->nnz);
+    else if(data->stream != NULL)
+        fprintf(outputFile, "Storage: out-of-core, %d blocks of %d rows\n",
+                data->stream->blocks, data->stream->blockRows);
+    else
+        fprintf(outputFile, "Storage: dense\n");
+
+    if(data->MaFloat != NULL)
+        fprintf(outputFile, "Precision: float Matrix A, double accumulation\n");
+
+    if(options.method == METHOD_GAUSS_SEIDEL)
+        fprintf(outputFile, "Method: gauss-seidel\n");
+    else if(options.method == METHOD_SOR)
+        fprintf(outputFile, "Method: sor, omega %lf\n", relaxationFactor(data, data->engine->threads()));
+    else if(options.method == METHOD_CHEBYSHEV)
+        fprintf(outputFile, "Method: chebyshev, eigenvalues in [%lf, %lf], rho %lf\n",
+                data->spectrum.low, data->spectrum.high, data->spectrum.rho);
+    else if(options.async)
+        fprintf(outputFile, "Method: jacobi, asynchronous\n");
+
+    if(data->coloring != NULL)
+        fprintf(outputFile, "Ordering: %d colors\n", data->coloring->colors);
+}
+
+
+
+void sweepCost(Data *data, double *flops, double *bytes){
+
+    double order = data->J_ORDER;
+    double rhs = data->rhsCount;
+    double nnz;
+
+    // x and Array B are read and the new x written once per right-hand side
+    *bytes = 3 * order * rhs * sizeof(double);
+
+    if(data->sparse != NULL){
+        nnz = data->sparse->nnz;
+        *flops = 2 * nnz * rhs;
+        *bytes += nnz * (sizeof(double) + sizeof(int)) + (order + 1) * sizeof(size_t);
+    }
+    else{
+        *flops = 2 * order * order * rhs;
+        *bytes += order * order * (data->useFloat ? sizeof(float) : sizeof(double));
+    }
+}
+
+void printData(Data data){
+
+    int i, j;
+
+    printf("\nPrint Data\n");
+    printf("=================================\n");
+
+    printf("J_ORDER: %d\nJ_ROW_TEST: %d\nJ_ERROR: %lf\n", data.J_ORDER, data.J_ROW_TEST, data.J_ERROR);
+
+    for(i = 0; i < data.J_ORDER && data.Ma != NULL; i++){
+        for(j = 0; j < data.J_ORDER; j++){
+            printf("%lf ", data.Ma[(size_t) i * data.lda + j]);
+        }
+        printf("\n");
+    }
+    for(i = 0; i < data.J_ORDER; i++){
+        printf("%lf \n", data.Mb[i]);
+    }
+
+}
+
+void freeData(Data *data){
+
+    // Free Matrix A, a mapped matrix is released with the mapping
+    if(data->mapped.base == NULL)
+        free(data->Ma);
+
+    if(data->stream != NULL){
+        streamClose(data->stream);
+        free(data->stream);
+    }
+
+    if(data->checkpoint != NULL){
+        checkpointClose(data->checkpoint);
+        free(data->checkpoint);
+    }
+
+    free(data->initial);
+    free(data->solution);
+
+    if(data->sparse != NULL){
+        freeCsr(data->sparse);
+        free(data->sparse);
+    }
+
+    free(data->MaFloat);
+    free(data->testedRow);
+    free(data->testedB);
+    if(data->coloring != NULL){
+        freeColoring(data->coloring);
+        free(data->coloring);
+    }
+
+    // Free Mb pointer
+    if(data->mapped.base == NULL || data->Mb != data->mapped.b)
+        free(data->Mb);
+
+    unmapBinaryMatrix(&data->mapped);
+
+    // finally free the structure
+    free(data);
+}
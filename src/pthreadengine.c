@@ -0,0 +1,1146 @@
+#include <stdio.h>
+#include <time.h>
+#include <math.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "solver.h"
+#include "pool.h"
+#include "rhs.h"
+#include "barrier.h"
+#include "topology.h"
+#include "trace.h"
+#include "counters.h"
+
+/**
+ * Pthreads engine, the sweeps of the original parallel program on a pool of
+ * options.numberOfThreads workers (every processor when it is 0)
+ */
+
+/**
+ *
+ * For the sake of simplicty this variables will be declared as global.
+ *
+ * Threads used to calculate each matrix block
+ *
+ */
+typedef struct {
+    double J_ERROR;
+    int J_ITE_MAX;
+    int J_ORDER;
+    int start;
+    int end;
+    double *Ma;
+    int lda;
+    CsrMatrix *sparse;
+    float *MaFloat;
+    int ldaFloat;
+    double *Mb;
+    int rhsCount;
+    double omega;
+    Spectrum *spectrum;
+    Coloring *coloring;
+    StreamMatrix *stream;
+    Checkpoint *checkpoint;
+    int tNumber;
+    int numberOfThreads;
+    
+} pthreadData;
+
+
+// Workers created once and reused by every solve
+static ThreadPool *pool;
+static int numberOfThreads;
+
+static pthreadData *pthreadsData;
+
+// Barrier created to sync all the threads
+// This is necessary in order guarantee that all the threads are calculating
+// the same value of x (awnser array)
+static Barrier barrier;
+
+// CPUs the workers are pinned to (--pin)
+static Topology topology;
+
+// Performance counters of each worker (--counters)
+static CounterSlot *counterSlots;
+
+/**
+ * Max error found by a thread on its own rows. Each slot takes a whole cache
+ * line so the threads never write to the same line
+ */
+typedef struct {
+    double value;
+    char padding[64 - sizeof(double)];
+} __attribute__((aligned(64))) ErrorSlot;
+
+/**
+ * State of a thread in the asynchronous mode, one cache line each
+ * iterations: Sweeps over its rows
+ * error: Max relative change of its last sweep
+ * quietAt: Value of asyncActivity when its last sweep started, if that
+ * sweep stayed below J_ERROR, -1 otherwise
+ */
+typedef struct {
+    int iterations;
+    double error;
+    long quietAt;
+    char padding[64 - sizeof(int) - sizeof(double) - sizeof(long)];
+} __attribute__((aligned(64))) AsyncSlot;
+
+
+static ErrorSlot *errorSlots;
+static double *x_current;
+static double *x_next;
+// X(k-1) and the weight of the next iteration with --method chebyshev, x_previous
+// is NULL for plain Jacobi-Richardson
+static double *x_previous;
+static double chebyshevOmega;
+static double maxError = 100;
+// Right-hand sides of a multiple solve and the error of each thread on every
+// active one, a row of rhsStride values (whole cache lines) per thread
+static RhsSet rhs;
+static double *rhsErrors;
+static int rhsStride;
+// Asynchronous mode: per-thread state, number of sweeps that ended above
+// J_ERROR so far and the stop flag
+static AsyncSlot *asyncSlots;
+static long asyncActivity;
+static int asyncStop;
+
+/**
+ * Gauss-Seidel and SOR, see relax.h. Same stop criteria and output as
+ * JacobiRichardson
+ */
+static void GaussSeidel(Data *data);
+
+/**
+ * The iterative method itself
+ *
+ * It calculates X(k+1) = -(L* + R*)x(k) + b*
+ * whlie the error < J_ERROR or number of iterations reached < J_ITE_MAX
+ *
+ */
+static void JacobiRichardson(Data *data);
+
+/**
+ * Same method for several right-hand sides at once, see rhs.h. Every row of
+ * Matrix A is read once per iteration for all the active right-hand sides
+ */
+static void JacobiRichardsonMultiple(Data *data);
+
+/**
+ * JacobiRichardson on an out-of-core Matrix A (see stream.h). The output
+ * also has the read throughput and the time the workers waited for blocks
+ */
+static void JacobiRichardsonStream(Data *data);
+
+/**
+ * Function that shall be passed to each thread
+ * 
+ * Each thread will be responsible for a part of the matrix. We will divide the
+ * matrix in several blocks according to the number of threads required by the
+ * user
+ *
+ * In order to keep the result consistent we have to user a barrier to sync all
+ * the threads. This must be done at the end of each iteration, after that all
+ * the threads can proceed to do the next iteration
+ *
+ * int start/end: Range of rows that the threads will be responsible
+ * int J_ORDER: Matriz Order
+ * double* Ma: Pointer to Matrix A, row i starts at Ma + i * lda
+ * CsrMatrix* sparse: Matrix A in CSR format, used instead of Ma when set
+ * float* MaFloat: Matrix A stored as float, used instead of Ma when set
+ * double *Mb: Pointer to array B
+ * double *x_current: Pointer to the current x_values (also know as xk)
+ * double *x_next: Pointer to the values being calculated by this iteration
+ * (also know as xk+1)
+ *
+ */
+static void* calculateBlock(void *rawData);
+
+/**
+ * calculateBlock for several right-hand sides: each row of Matrix A is
+ * multiplied by all the active columns of the interleaved x at once
+ *
+ */
+static void* calculateMultiBlock(void *rawData);
+
+/**
+ * calculateBlock for an out-of-core Matrix A: every iteration goes through
+ * the blocks in order as the reader delivers them, each thread taking its
+ * share of the rows of every block
+ *
+ */
+static void* calculateStreamBlock(void *rawData);
+
+/**
+ * calculateBlock for Gauss-Seidel and SOR. A dense matrix is swept block by
+ * block, each thread reading the other blocks from the previous iteration.
+ * The rows of a sparse matrix are updated color by color, every thread
+ * taking a share of each color
+ *
+ */
+static void* calculateRelaxBlock(void *rawData);
+
+/**
+ * Asynchronous (chaotic) Jacobi-Richardson, no barrier at all
+ *
+ * Every thread sweeps its rows over and over, writing x in place and reading
+ * whatever values the other threads left there. There is no global swap to
+ * compare the iterates, so termination is detected by the threads
+ * themselves: a sweep above J_ERROR bumps asyncActivity, a sweep below it
+ * publishes the value asyncActivity had when it started. Once every thread
+ * has published the current value, all of them swept quietly after the last
+ * change anywhere and the thread that sees it raises the stop flag. Reaching
+ * J_ITE_MAX sweeps also raises it
+ *
+ */
+static void* calculateAsyncBlock(void *rawData);
+
+/**
+ * Pin the worker to its CPU (see topology.h), run once by startThreads
+ *
+ */
+static void* pinWorker(void *rawData);
+
+/**
+ * Zero the rows of the thread before Matrix A is read, so with --pin its
+ * pages are placed on the node of the thread that sweeps them
+ *
+ */
+static void* touchBlock(void *rawData);
+
+/**
+ * prepareMatrices on the rows of the thread
+ *
+ */
+static void* prepareBlock(void *rawData);
+
+/**
+ * JacobiRichardson with calculateAsyncBlock. The output also has the sweeps
+ * of each thread and the residual max |b* - x - (L* + R*)x| of the result
+ */
+static void JacobiRichardsonAsync(Data *data);
+
+/**
+ * Write the time each thread spent in the barrier during the last solve
+ */
+static void printBarrierWait(int numberOfThreads);
+
+/**
+ * Set the workload of each thread according to the matrix order, number of
+ * threads available and options.partition (see rowBlock)
+ *
+ */
+static void prepareThreads(Data* data);
+
+/**
+ * Create the worker pool, the barrier and the per-thread data. They are
+ * created once and reused by every solve, so thread creation and teardown
+ * stay out of the measured time
+ *
+ */
+static void startThreads(int numberOfThreads);
+
+/**
+ * Stop the worker pool and release everything created by startThreads
+ *
+ */
+static void stopThreads(void);
+
+static void prepareThreads(Data *data){
+
+    int i;
+
+    for(i = 0; i < numberOfThreads; i++){
+        pthreadsData[i].J_ORDER = data->J_ORDER;
+        pthreadsData[i].J_ERROR = data->J_ERROR;
+        pthreadsData[i].J_ITE_MAX = data->J_ITE_MAX;
+        rowBlock(data->J_ORDER, numberOfThreads, i, &pthreadsData[i].start, &pthreadsData[i].end);
+        pthreadsData[i].Ma = data->Ma;
+        pthreadsData[i].lda = data->lda;
+        pthreadsData[i].sparse = data->sparse;
+        pthreadsData[i].MaFloat = data->useFloat ? data->MaFloat : NULL;
+        pthreadsData[i].ldaFloat = data->ldaFloat;
+        pthreadsData[i].omega = relaxationFactor(data, numberOfThreads);
+        pthreadsData[i].spectrum = &data->spectrum;
+        pthreadsData[i].coloring = data->coloring;
+        pthreadsData[i].stream = data->stream;
+        pthreadsData[i].checkpoint = data->checkpoint;
+        pthreadsData[i].Mb = data->Mb;
+        pthreadsData[i].rhsCount = data->rhsCount;
+        pthreadsData[i].tNumber = i;
+        pthreadsData[i].numberOfThreads = numberOfThreads;
+    }
+}
+
+static void startThreads(int numberOfThreads){
+
+    int i;
+
+    // One error slot per thread
+    posix_memalign((void**) &errorSlots, sizeof(ErrorSlot), sizeof(ErrorSlot) * numberOfThreads);
+    // Allocate memory for the data of each thread, filled by prepareThreads
+    pthreadsData = (pthreadData*) malloc (sizeof(pthreadData) * numberOfThreads);
+
+    // Initialize barrier, spinning or pthread_barrier_t (--barrier)
+    // the last parameter is the number of threads that must wait in the
+    // barrier before all the threads can proceed further
+    barrierInit(&barrier, numberOfThreads, options.barrier);
+
+    pool = poolCreate(numberOfThreads);
+
+    // Opened by each worker on its first solve
+    posix_memalign((void**) &counterSlots, sizeof(CounterSlot), sizeof(CounterSlot) * numberOfThreads);
+    countersInit(counterSlots, numberOfThreads);
+
+    // Pin every worker once, the pool keeps the same threads
+    if(options.pin){
+        readTopology(&topology, numberOfThreads);
+        placeOnFirstTouch();
+        for(i = 0; i < numberOfThreads; i++){
+            pthreadsData[i].tNumber = i;
+        }
+        poolRun(pool, &pinWorker, pthreadsData, sizeof(pthreadData));
+    }
+}
+
+static void stopThreads(void){
+
+    poolDestroy(pool);
+    countersClose(counterSlots, numberOfThreads);
+    free(counterSlots);
+
+    barrierDestroy(&barrier);
+    if(options.pin)
+        freeTopology(&topology);
+    free(pthreadsData);
+    free(errorSlots);
+}
+
+
+static void printBarrierWait(int numberOfThreads){
+
+    int t;
+
+    for(t = 0; t < numberOfThreads; t++){
+        fprintf(outputFile, "Barrier wait: thread %d %lf\n", t, barrier.slots[t].waitTime);
+    }
+}
+
+static void JacobiRichardson(Data *data){
+
+    // Control variables
+    int i;
+    struct timespec start, finish;
+    double time_spent;
+
+    if(options.method != METHOD_JACOBI && options.method != METHOD_CHEBYSHEV){
+        GaussSeidel(data);
+        return;
+    }
+
+    if(data->rhsCount > 1){
+        JacobiRichardsonMultiple(data);
+        return;
+    }
+
+    if(options.async){
+        JacobiRichardsonAsync(data);
+        return;
+    }
+
+    if(data->stream != NULL){
+        JacobiRichardsonStream(data);
+        return;
+    }
+
+    // Current x value, initial value is 0 (or the initial guess) for sake of simplicity
+    // Allocates memory for the x values, 
+    // the starting point is 0 or the initial guess (see startIterate)
+    // final awnser will be placed at x_next
+    x_current = (double*) malloc(sizeof(double) * data->J_ORDER);
+    startIterate(data, x_current);
+    x_next = (double*) malloc(sizeof(double) * data->J_ORDER);
+
+    // A resumed solve starts from the saved iterate
+    if(data->checkpoint != NULL)
+        iterations = checkpointBegin(data->checkpoint, x_current);
+
+    if(options.method == METHOD_CHEBYSHEV){
+        x_previous = (double*) malloc(sizeof(double) * data->J_ORDER);
+        startIterate(data, x_previous);
+        chebyshevOmega = 1;
+    }
+
+    // The calculation is not over until the error is lesser than J_ERROR or
+    // we haven't reach the maxium number of iterations allowed
+
+    TRACE_START(numberOfThreads);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    // Hand the new rows to the parked workers and wait for all of them
+    barrierResetWait(&barrier);
+    poolRun(pool, &calculateBlock, pthreadsData, sizeof(pthreadData));
+
+
+    // Calculates the value for row J_ROW_TEST
+    double result = 0;
+    for(i = 0; i < data->J_ORDER; i++){
+        result = result + data->testedRow[i]*x_current[i];  
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &finish);
+
+    rowTestResult = result;
+    time_spent = elapsedTime(start, finish);
+
+    timeSpent = time_spent;
+
+    fprintf(outputFile, "===========================================\n");
+    fprintf(outputFile, "Time Spent %lf\n" , time_spent);
+    fprintf(outputFile, "Iterations %d\n", iterations);
+    fprintf(outputFile, "RowTest: %d => [%lf] =? [%lf]\n", data->J_ROW_TEST, result, data->testedB[0]);
+    if(data->checkpoint != NULL)
+        checkpointEnd(data->checkpoint);
+    printBarrierWait(numberOfThreads);
+    if(options.counters)
+        printCounters(counterSlots, numberOfThreads, data);
+    TRACE_FINISH(pthreadEngine.name);
+
+    keepSolution(data, x_current);
+    free(x_current);
+    free(x_next);
+    free(x_previous);
+    x_previous = NULL;
+}
+
+static void JacobiRichardsonStream(Data *data){
+
+    int i;
+    struct timespec start, finish;
+    double result = 0;
+    double megabytes;
+    StreamMatrix *stream = data->stream;
+
+    x_current = (double*) malloc(sizeof(double) * data->J_ORDER);
+    startIterate(data, x_current);
+    x_next = (double*) malloc(sizeof(double) * data->J_ORDER);
+
+    if(data->checkpoint != NULL)
+        iterations = checkpointBegin(data->checkpoint, x_current);
+
+    TRACE_START(numberOfThreads);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    // The reading is part of the solve, it starts with the clock
+    streamStart(stream, numberOfThreads);
+    barrierResetWait(&barrier);
+    poolRun(pool, &calculateStreamBlock, pthreadsData, sizeof(pthreadData));
+    streamStop(stream);
+
+    for(i = 0; i < data->J_ORDER; i++){
+        result = result + data->testedRow[i]*x_current[i];
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &finish);
+
+    rowTestResult = result;
+    timeSpent = elapsedTime(start, finish);
+
+    megabytes = (double) stream->order * stream->lda * sizeof(double) / 1e6;
+
+    fprintf(outputFile, "===========================================\n");
+    fprintf(outputFile, "Time Spent %lf\n" , timeSpent);
+    fprintf(outputFile, "Iterations %d\n", iterations);
+    fprintf(outputFile, "RowTest: %d => [%lf] =? [%lf]\n", data->J_ROW_TEST, result, data->testedB[0]);
+    fprintf(outputFile, "Stream: %.1lf MB per iteration, %.1lf MB read in %lf s, %.1lf MB/s (%.1lf slowest, %.1lf fastest iteration)\n",
+            megabytes, stream->bytesRead / 1e6, stream->readTime,
+            stream->readTime > 0 ? stream->bytesRead / 1e6 / stream->readTime : 0,
+            stream->slowest / 1e6, stream->fastest / 1e6);
+    fprintf(outputFile, "Stream wait: %lf s over all threads\n", stream->waitTime);
+    if(data->checkpoint != NULL)
+        checkpointEnd(data->checkpoint);
+    printBarrierWait(numberOfThreads);
+    if(options.counters)
+        printCounters(counterSlots, numberOfThreads, data);
+    TRACE_FINISH(pthreadEngine.name);
+
+    keepSolution(data, x_current);
+    free(x_current);
+    free(x_next);
+}
+
+static void GaussSeidel(Data *data){
+
+    int i;
+    double result;
+    struct timespec start, finish;
+    double time_spent;
+
+    // Same starting point as JacobiRichardson
+    x_current = (double*) malloc(sizeof(double) * data->J_ORDER);
+    startIterate(data, x_current);
+    x_next = (double*) calloc(sizeof(double), data->J_ORDER);
+
+    TRACE_START(numberOfThreads);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    barrierResetWait(&barrier);
+    poolRun(pool, &calculateRelaxBlock, pthreadsData, sizeof(pthreadData));
+
+    result = 0;
+    for(i = 0; i < data->J_ORDER; i++){
+        result = result + data->testedRow[i]*x_current[i];
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &finish);
+
+    rowTestResult = result;
+    time_spent = elapsedTime(start, finish);
+    timeSpent = time_spent;
+
+    fprintf(outputFile, "===========================================\n");
+    fprintf(outputFile, "Time Spent %lf\n" , time_spent);
+    fprintf(outputFile, "Iterations %d\n", iterations);
+    fprintf(outputFile, "RowTest: %d => [%lf] =? [%lf]\n", data->J_ROW_TEST, result, data->testedB[0]);
+    printBarrierWait(numberOfThreads);
+    if(options.counters)
+        printCounters(counterSlots, numberOfThreads, data);
+    TRACE_FINISH(pthreadEngine.name);
+
+    keepSolution(data, x_current);
+    free(x_current);
+    free(x_next);
+}
+
+static void JacobiRichardsonAsync(Data *data){
+
+    int i, t;
+    double result, value, residual;
+    double *row;
+    struct timespec start, finish;
+    double time_spent;
+
+    // A single x, updated in place by every thread
+    x_current = (double*) malloc(sizeof(double) * data->J_ORDER);
+    startIterate(data, x_current);
+    posix_memalign((void**) &asyncSlots, sizeof(AsyncSlot), sizeof(AsyncSlot) * numberOfThreads);
+    for(t = 0; t < numberOfThreads; t++){
+        asyncSlots[t].quietAt = -1;
+    }
+    asyncActivity = 0;
+    asyncStop = 0;
+
+    TRACE_START(numberOfThreads);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    poolRun(pool, &calculateAsyncBlock, pthreadsData, sizeof(pthreadData));
+
+    // Threads sweep at their own pace, report the furthest one
+    for(t = 0; t < numberOfThreads; t++){
+        if(asyncSlots[t].iterations > iterations)
+            iterations = asyncSlots[t].iterations;
+    }
+
+    result = 0;
+    for(i = 0; i < data->J_ORDER; i++){
+        result = result + data->testedRow[i]*x_current[i];
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &finish);
+
+    rowTestResult = result;
+    time_spent = elapsedTime(start, finish);
+    timeSpent = time_spent;
+
+    // Distance of the result from a fixed point of the iteration
+    residual = 0;
+    for(i = 0; i < data->J_ORDER; i++){
+        if(data->sparse != NULL){
+            value = csrRowDot(data->sparse, i, x_current);
+        }
+        else if(data->useFloat){
+            value = kernel->dotFloat(data->MaFloat + (size_t) i * data->ldaFloat, x_current, data->J_ORDER);
+        }
+        else{
+            row = data->Ma + (size_t) i * data->lda;
+            value = kernel->dot(row, x_current, data->J_ORDER);
+        }
+        value = fabs(data->Mb[i] - value - x_current[i]);
+        if(value > residual)
+            residual = value;
+    }
+
+    fprintf(outputFile, "===========================================\n");
+    fprintf(outputFile, "Time Spent %lf\n" , time_spent);
+    fprintf(outputFile, "Iterations %d\n", iterations);
+    fprintf(outputFile, "RowTest: %d => [%lf] =? [%lf]\n", data->J_ROW_TEST, result, data->testedB[0]);
+    fprintf(outputFile, "Residual %e\n", residual);
+    for(t = 0; t < numberOfThreads; t++){
+        fprintf(outputFile, "Thread %d: %d iterations, last error %e\n", t,
+                asyncSlots[t].iterations, asyncSlots[t].error);
+    }
+    if(options.counters)
+        printCounters(counterSlots, numberOfThreads, data);
+    TRACE_FINISH(pthreadEngine.name);
+
+    free(asyncSlots);
+    keepSolution(data, x_current);
+    free(x_current);
+}
+
+static void JacobiRichardsonMultiple(Data *data){
+
+    int r;
+    int k = data->rhsCount;
+    double result;
+    struct timespec start, finish;
+    double time_spent;
+
+    // Interleaved x of every right-hand side, starting at 0
+    x_current = (double*) calloc(sizeof(double), (size_t) data->J_ORDER * k);
+    x_next = (double*) calloc(sizeof(double), (size_t) data->J_ORDER * k);
+
+    rhsStride = ((k + 7) / 8) * 8;
+    posix_memalign((void**) &rhsErrors, 64, sizeof(double) * rhsStride * numberOfThreads);
+
+    TRACE_START(numberOfThreads);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    rhsStart(&rhs, data->Mb, data->J_ORDER, k);
+
+    barrierResetWait(&barrier);
+    poolRun(pool, &calculateMultiBlock, pthreadsData, sizeof(pthreadData));
+
+    rhsFinish(&rhs, x_current, iterations);
+
+    clock_gettime(CLOCK_MONOTONIC, &finish);
+
+    time_spent = elapsedTime(start, finish);
+    timeSpent = time_spent;
+
+    fprintf(outputFile, "===========================================\n");
+    fprintf(outputFile, "Time Spent %lf\n" , time_spent);
+    fprintf(outputFile, "Iterations %d\n", iterations);
+    for(r = 0; r < k; r++){
+        result = rhsRowTest(&rhs, data->testedRow, r);
+        if(r == 0)
+            rowTestResult = result;
+
+        fprintf(outputFile, "RowTest: %d => [%lf] =? [%lf] (rhs %d, %d iterations)\n",
+                data->J_ROW_TEST, result, data->testedB[r], r, rhs.iterations[r]);
+    }
+
+    printBarrierWait(numberOfThreads);
+    if(options.counters)
+        printCounters(counterSlots, numberOfThreads, data);
+    TRACE_FINISH(pthreadEngine.name);
+
+    rhsFree(&rhs);
+    free(rhsErrors);
+    free(x_current);
+    free(x_next);
+}
+
+static void* calculateBlock(void* rawData){
+
+	pthreadData* tData = (pthreadData*) rawData;
+	int i;
+	double temp_result = 0;
+	double* temp;
+	double* row;
+	double error;
+	double localError;
+
+	if(options.counters)
+		countersBegin(&counterSlots[tData->tNumber]);
+
+	do{
+
+		TRACE_BEGIN(sweep);
+		localError = 0;
+
+		// Dense rows of the block in register tiles against cache-sized
+		// blocks of x, the products land in x_next
+		if(tData->sparse == NULL && tData->MaFloat == NULL){
+			row = tData->Ma + (size_t) tData->start * tData->lda;
+			multiRowDot(kernel, &blocking, row, tData->lda, tData->end - tData->start,
+					x_current, tData->J_ORDER, x_next + tData->start);
+		}
+
+		for(i = tData->start; i < tData->end; i++){
+			if(tData->sparse != NULL){
+				temp_result = csrRowDot(tData->sparse, i, x_current);
+			}
+			else if(tData->MaFloat != NULL){
+				temp_result = kernel->dotFloat(tData->MaFloat + (size_t) i * tData->ldaFloat, x_current, tData->J_ORDER);
+			}
+			else{
+				temp_result = x_next[i];
+			}
+			x_next[i] = - temp_result + tData->Mb[i];
+			// Chebyshev, the row only needs its own x(k) and x(k-1)
+			if(x_previous != NULL)
+				x_next[i] = chebyshevRow(tData->spectrum, chebyshevOmega, x_next[i], x_current[i], x_previous[i]);
+
+			error = fabs((x_next[i] - x_current[i])/ x_next[i]);
+			if(error > localError)
+				localError = error;
+
+		}
+		errorSlots[tData->tNumber].value = localError;
+		TRACE_END(tData->tNumber, "sweep", sweep);
+
+		TRACE_BEGIN(arrive);
+		int r = barrierWait(&barrier, tData->tNumber);
+		TRACE_END(tData->tNumber, "barrier", arrive);
+
+		if(r == PTHREAD_BARRIER_SERIAL_THREAD){
+			TRACE_BEGIN(check);
+			temp = x_current;
+			x_current = x_next;
+			x_next = temp;	
+			iterations++;
+
+			// The oldest iterate is the one overwritten next
+			if(x_previous != NULL){
+				x_next = x_previous;
+				x_previous = temp;
+				chebyshevOmega = chebyshevWeight(tData->spectrum, iterations, chebyshevOmega);
+			}
+
+			// Only one slot per thread to combine, not one per row
+			maxError = errorSlots[0].value;
+			for(i = 1; i < tData->numberOfThreads; i++){
+				if(errorSlots[i].value > maxError)
+					maxError = errorSlots[i].value;
+			}
+			if(tData->checkpoint != NULL)
+				checkpointIteration(tData->checkpoint, x_current, iterations, maxError);
+			TRACE_END(tData->tNumber, "check", check);
+			TRACE_COUNTER(tData->tNumber, "error", maxError);
+		}
+
+		// wait all the other thread to proceed to the next iteration
+		TRACE_BEGIN(release);
+		barrierWait(&barrier, tData->tNumber);
+		TRACE_END(tData->tNumber, "barrier", release);
+	} while (maxError > tData->J_ERROR && iterations < tData->J_ITE_MAX);
+
+	if(options.counters)
+		countersEnd(&counterSlots[tData->tNumber]);
+
+	return NULL;
+}
+
+static void* calculateStreamBlock(void* rawData){
+
+	pthreadData* tData = (pthreadData*) rawData;
+	StreamMatrix *stream = tData->stream;
+	const double *rows;
+	double *temp;
+	double error;
+	double localError;
+	long sequence = 0;
+	int i, block, first, count, start, end;
+	int failed = 0;
+
+	if(options.counters)
+		countersBegin(&counterSlots[tData->tNumber]);
+
+	do{
+
+		TRACE_BEGIN(sweep);
+		localError = 0;
+
+		for(block = 0; block < stream->blocks; block++, sequence++){
+			first = block * stream->blockRows;
+			count = stream->order - first < stream->blockRows ? stream->order - first : stream->blockRows;
+			rowBlock(count, tData->numberOfThreads, tData->tNumber, &start, &end);
+
+			// Every thread misses the same block, they all stop after it
+			rows = streamAcquire(stream, sequence);
+			if(rows == NULL){
+				failed = 1;
+				break;
+			}
+			multiRowDot(kernel, &blocking, rows + (size_t) start * stream->lda, stream->lda, end - start,
+					x_current, tData->J_ORDER, x_next + first + start);
+			streamRelease(stream, sequence);
+
+			for(i = first + start; i < first + end; i++){
+				x_next[i] = - x_next[i] + tData->Mb[i];
+
+				error = fabs((x_next[i] - x_current[i])/ x_next[i]);
+				if(error > localError)
+					localError = error;
+			}
+		}
+		errorSlots[tData->tNumber].value = localError;
+		TRACE_END(tData->tNumber, "sweep", sweep);
+
+		TRACE_BEGIN(arrive);
+		int r = barrierWait(&barrier, tData->tNumber);
+		TRACE_END(tData->tNumber, "barrier", arrive);
+
+		if(r == PTHREAD_BARRIER_SERIAL_THREAD && !failed){
+			TRACE_BEGIN(check);
+			temp = x_current;
+			x_current = x_next;
+			x_next = temp;
+			iterations++;
+
+			maxError = errorSlots[0].value;
+			for(i = 1; i < tData->numberOfThreads; i++){
+				if(errorSlots[i].value > maxError)
+					maxError = errorSlots[i].value;
+			}
+			if(tData->checkpoint != NULL)
+				checkpointIteration(tData->checkpoint, x_current, iterations, maxError);
+			TRACE_END(tData->tNumber, "check", check);
+			TRACE_COUNTER(tData->tNumber, "error", maxError);
+		}
+
+		TRACE_BEGIN(release);
+		barrierWait(&barrier, tData->tNumber);
+		TRACE_END(tData->tNumber, "barrier", release);
+	} while (!failed && maxError > tData->J_ERROR && iterations < tData->J_ITE_MAX);
+
+	if(options.counters)
+		countersEnd(&counterSlots[tData->tNumber]);
+
+	return NULL;
+}
+
+static void* calculateMultiBlock(void* rawData){
+
+	pthreadData* tData = (pthreadData*) rawData;
+	int i, c, t;
+	int k = rhs.count;
+	int active;
+	double* temp;
+	double* row;
+	double* localErrors = rhsErrors + (size_t) tData->tNumber * rhsStride;
+	double value, error;
+
+	if(options.counters)
+		countersBegin(&counterSlots[tData->tNumber]);
+
+	do{
+		TRACE_BEGIN(sweep);
+
+		// Read once per iteration, only the serial thread changes it
+		active = rhs.active;
+
+		for(c = 0; c < active; c++){
+			localErrors[c] = 0;
+		}
+
+		for(i = tData->start; i < tData->end; i++){
+			if(tData->sparse != NULL){
+				csrRowMultiDot(tData->sparse, i, x_current, k, active, x_next + (size_t) i * k);
+			}
+			else{
+				row = tData->Ma + (size_t) i * tData->lda;
+				kernel->multiDot(row, x_current, k, active, tData->J_ORDER, x_next + (size_t) i * k);
+			}
+
+			for(c = 0; c < active; c++){
+				value = - x_next[(size_t) i * k + c] + rhs.b[(size_t) i * k + c];
+				x_next[(size_t) i * k + c] = value;
+
+				error = fabs((value - x_current[(size_t) i * k + c]) / value);
+				if(error > localErrors[c])
+					localErrors[c] = error;
+			}
+		}
+
+		TRACE_END(tData->tNumber, "sweep", sweep);
+
+		TRACE_BEGIN(arrive);
+		int r = barrierWait(&barrier, tData->tNumber);
+		TRACE_END(tData->tNumber, "barrier", arrive);
+
+		if(r == PTHREAD_BARRIER_SERIAL_THREAD){
+			TRACE_BEGIN(check);
+			temp = x_current;
+			x_current = x_next;
+			x_next = temp;
+			iterations++;
+
+			// Max error of each right-hand side over the threads
+			for(c = 0; c < active; c++){
+				rhs.errors[c] = 0;
+				for(t = 0; t < tData->numberOfThreads; t++){
+					if(rhsErrors[(size_t) t * rhsStride + c] > rhs.errors[c])
+						rhs.errors[c] = rhsErrors[(size_t) t * rhsStride + c];
+				}
+			}
+
+			// Converged right-hand sides leave the active columns
+			rhsRetire(&rhs, x_current, tData->J_ERROR, iterations);
+			TRACE_END(tData->tNumber, "check", check);
+		}
+
+		TRACE_BEGIN(release);
+		barrierWait(&barrier, tData->tNumber);
+		TRACE_END(tData->tNumber, "barrier", release);
+	} while (rhs.active > 0 && iterations < tData->J_ITE_MAX);
+
+	if(options.counters)
+		countersEnd(&counterSlots[tData->tNumber]);
+
+	return NULL;
+}
+
+static void* calculateRelaxBlock(void* rawData){
+
+	pthreadData* tData = (pthreadData*) rawData;
+	const Coloring *coloring = tData->coloring;
+	int i, c, k, first, last, length;
+	double* temp;
+	double rowError;
+	double localError;
+
+	if(options.counters)
+		countersBegin(&counterSlots[tData->tNumber]);
+
+	do{
+
+		TRACE_BEGIN(sweep);
+		localError = 0;
+		if(tData->sparse != NULL){
+			// x is updated in place, a color starts once the previous one is
+			// done by every thread
+			for(c = 0; c < coloring->colors; c++){
+				length = coloring->colorStart[c + 1] - coloring->colorStart[c];
+				first = coloring->colorStart[c] + (int) ((long) length * tData->tNumber / tData->numberOfThreads);
+				last = coloring->colorStart[c] + (int) ((long) length * (tData->tNumber + 1) / tData->numberOfThreads);
+
+				for(k = first; k < last; k++){
+					rowError = relaxSparseRow(tData->sparse, tData->Mb, coloring->rows[k], tData->omega, x_current);
+					if(rowError > localError)
+						localError = rowError;
+				}
+
+				barrierWait(&barrier, tData->tNumber);
+			}
+		}
+		else{
+			localError = sweepDenseBlock(kernel, tData->Ma, tData->lda, tData->Mb, tData->J_ORDER,
+					tData->start, tData->end, tData->omega, x_current, x_next);
+		}
+		errorSlots[tData->tNumber].value = localError;
+		TRACE_END(tData->tNumber, "sweep", sweep);
+
+		TRACE_BEGIN(arrive);
+		int r = barrierWait(&barrier, tData->tNumber);
+		TRACE_END(tData->tNumber, "barrier", arrive);
+
+		if(r == PTHREAD_BARRIER_SERIAL_THREAD){
+			TRACE_BEGIN(check);
+			if(tData->sparse == NULL){
+				temp = x_current;
+				x_current = x_next;
+				x_next = temp;
+			}
+			iterations++;
+
+			maxError = errorSlots[0].value;
+			for(i = 1; i < tData->numberOfThreads; i++){
+				if(errorSlots[i].value > maxError)
+					maxError = errorSlots[i].value;
+			}
+			TRACE_END(tData->tNumber, "check", check);
+			TRACE_COUNTER(tData->tNumber, "error", maxError);
+		}
+
+		TRACE_BEGIN(release);
+		barrierWait(&barrier, tData->tNumber);
+		TRACE_END(tData->tNumber, "barrier", release);
+	} while (maxError > tData->J_ERROR && iterations < tData->J_ITE_MAX);
+
+	if(options.counters)
+		countersEnd(&counterSlots[tData->tNumber]);
+
+	return NULL;
+}
+
+static void* calculateAsyncBlock(void* rawData){
+
+	pthreadData* tData = (pthreadData*) rawData;
+	AsyncSlot *slot = &asyncSlots[tData->tNumber];
+	int i, t;
+	int sweeps = 0;
+	long startedAt, activity;
+	double temp_result, value, error;
+	double localError = 0;
+	double* row;
+
+	if(options.counters)
+		countersBegin(&counterSlots[tData->tNumber]);
+
+	// The values of the other threads are read without any synchronization,
+	// chaotic relaxation converges with whatever iterate it sees
+	while(!__atomic_load_n(&asyncStop, __ATOMIC_ACQUIRE)){
+
+		startedAt = __atomic_load_n(&asyncActivity, __ATOMIC_ACQUIRE);
+
+		TRACE_BEGIN(sweep);
+		localError = 0;
+		for(i = tData->start; i < tData->end; i++){
+			if(tData->sparse != NULL){
+				temp_result = csrRowDot(tData->sparse, i, x_current);
+			}
+			else if(tData->MaFloat != NULL){
+				temp_result = kernel->dotFloat(tData->MaFloat + (size_t) i * tData->ldaFloat, x_current, tData->J_ORDER);
+			}
+			else{
+				row = tData->Ma + (size_t) i * tData->lda;
+				temp_result = kernel->dot(row, x_current, tData->J_ORDER);
+			}
+			value = - temp_result + tData->Mb[i];
+
+			error = fabs((value - x_current[i])/ value);
+			if(error > localError)
+				localError = error;
+
+			x_current[i] = value;
+		}
+		sweeps++;
+		TRACE_END(tData->tNumber, "sweep", sweep);
+		TRACE_COUNTER(tData->tNumber, "error", localError);
+
+		if(localError > tData->J_ERROR){
+			__atomic_store_n(&slot->quietAt, -1, __ATOMIC_RELEASE);
+			__atomic_add_fetch(&asyncActivity, 1, __ATOMIC_ACQ_REL);
+		}
+		else{
+			__atomic_store_n(&slot->quietAt, startedAt, __ATOMIC_RELEASE);
+
+			// Everyone quiet since the last change, stop
+			activity = __atomic_load_n(&asyncActivity, __ATOMIC_ACQUIRE);
+			for(t = 0; t < tData->numberOfThreads; t++){
+				if(__atomic_load_n(&asyncSlots[t].quietAt, __ATOMIC_ACQUIRE) != activity)
+					break;
+			}
+			if(t == tData->numberOfThreads)
+				__atomic_store_n(&asyncStop, 1, __ATOMIC_RELEASE);
+		}
+
+		if(sweeps >= tData->J_ITE_MAX)
+			__atomic_store_n(&asyncStop, 1, __ATOMIC_RELEASE);
+	}
+
+	slot->iterations = sweeps;
+	slot->error = localError;
+
+	if(options.counters)
+		countersEnd(&counterSlots[tData->tNumber]);
+
+	return NULL;
+}
+
+static void* pinWorker(void* rawData){
+
+	pthreadData* tData = (pthreadData*) rawData;
+
+	pinThread(&topology, tData->tNumber);
+
+	return NULL;
+}
+
+static void* touchBlock(void* rawData){
+
+	pthreadData* tData = (pthreadData*) rawData;
+
+	touchRows(tData->Ma, tData->lda, tData->start, tData->end);
+
+	return NULL;
+}
+
+static void* prepareBlock(void* rawData){
+
+	pthreadData* tData = (pthreadData*) rawData;
+	int i, j;
+	double currentDiagonal;
+	double *row;
+
+	for(i = tData->start; i < tData->end; i++){
+
+		row = tData->Ma + (size_t) i * tData->lda;
+		currentDiagonal = row[i];
+
+		// Divide the array B by the respective diagonal value
+		for(j = 0; j < tData->rhsCount; j++){
+			tData->Mb[(size_t) i * tData->rhsCount + j] = tData->Mb[(size_t) i * tData->rhsCount + j] / currentDiagonal;
+		}
+		// We divide the position by the correpondent diagonal value
+		for(j = 0; j < tData->J_ORDER; j++){
+			row[j] = row[j] / currentDiagonal;
+		}
+		row[i] = 0;
+	}
+
+	return NULL;
+}
+
+
+static void startPthread(void){
+
+	numberOfThreads = options.numberOfThreads;
+	if(numberOfThreads == 0)
+		numberOfThreads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+
+	startThreads(numberOfThreads);
+	fprintf(outputFile, "Barrier: %s\n", barrierName(&barrier));
+	if(options.pin)
+		printTopology(outputFile, &topology);
+}
+
+static void placePthread(Data *data){
+
+	prepareThreads(data);
+	poolRun(pool, &touchBlock, pthreadsData, sizeof(pthreadData));
+}
+
+static void preparePthread(Data *data){
+
+	prepareThreads(data);
+	poolRun(pool, &prepareBlock, pthreadsData, sizeof(pthreadData));
+}
+
+/**
+ * The blocks are set again before every solve, checkPrecision switches
+ * between Ma and MaFloat
+ */
+static void solvePthread(Data *data){
+
+	prepareThreads(data);
+	JacobiRichardson(data);
+}
+
+static int threadsPthread(void){
+
+	return numberOfThreads;
+}
+
+/**
+ * A new pool of the given size, the old one is stopped first
+ */
+static void resizePthread(int threads){
+
+	if(threads == numberOfThreads)
+		return;
+
+	stopThreads();
+	numberOfThreads = threads;
+	startThreads(numberOfThreads);
+}
+
+const Engine pthreadEngine = {
+	"pthreads", startPthread, placePthread, preparePthread, solvePthread,
+	threadsPthread, resizePthread, stopThreads
+};
@@ -0,0 +1,172 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "relax.h"
+
+// Gauss-Seidel sweeps used to estimate omega
+#define OMEGA_SWEEPS 50
+
+// Largest convergence rate trusted by estimateOmega
+#define OMEGA_MAX_RATE 0.9999
+
+// Below this relative change the sweeps only measure rounding noise
+#define OMEGA_MIN_CHANGE 1e-9
+
+void colorRows(const CsrMatrix *matrix, Coloring *coloring){
+
+    int i, j, c, color;
+    int order = matrix->order;
+    size_t k;
+    size_t *transposeStart;
+    int *transposeRows;
+    size_t *count;
+    int *colors;
+    int *forbidden;
+
+    // Pattern of the transpose, rows j with A[j][i] stored
+    transposeStart = (size_t*) calloc(order + 1, sizeof(size_t));
+    transposeRows = (int*) malloc(sizeof(int) * matrix->nnz);
+    for(k = 0; k < matrix->nnz; k++){
+        transposeStart[matrix->columns[k] + 1]++;
+    }
+    for(i = 0; i < order; i++){
+        transposeStart[i + 1] += transposeStart[i];
+    }
+
+    count = (size_t*) malloc(sizeof(size_t) * order);
+    memcpy(count, transposeStart, sizeof(size_t) * order);
+    for(i = 0; i < order; i++){
+        for(k = matrix->rowStart[i]; k < matrix->rowStart[i + 1]; k++){
+            transposeRows[count[matrix->columns[k]]++] = i;
+        }
+    }
+    free(count);
+
+    // Smallest color not used by a neighbour already colored
+    colors = (int*) malloc(sizeof(int) * order);
+    forbidden = (int*) malloc(sizeof(int) * (order + 1));
+    for(i = 0; i <= order; i++){
+        forbidden[i] = -1;
+    }
+
+    coloring->colors = 0;
+    for(i = 0; i < order; i++){
+        for(k = matrix->rowStart[i]; k < matrix->rowStart[i + 1]; k++){
+            j = matrix->columns[k];
+            if(j < i)
+                forbidden[colors[j]] = i;
+        }
+        for(k = transposeStart[i]; k < transposeStart[i + 1]; k++){
+            j = transposeRows[k];
+            if(j < i)
+                forbidden[colors[j]] = i;
+        }
+
+        for(color = 0; forbidden[color] == i; color++);
+        colors[i] = color;
+        if(color + 1 > coloring->colors)
+            coloring->colors = color + 1;
+    }
+
+    // Bucket the rows by color, keeping them in order
+    coloring->colorStart = (int*) calloc(coloring->colors + 1, sizeof(int));
+    coloring->rows = (int*) malloc(sizeof(int) * order);
+    for(i = 0; i < order; i++){
+        coloring->colorStart[colors[i] + 1]++;
+    }
+    for(c = 0; c < coloring->colors; c++){
+        coloring->colorStart[c + 1] += coloring->colorStart[c];
+    }
+    for(c = 0; c < coloring->colors; c++){
+        forbidden[c] = coloring->colorStart[c];
+    }
+    for(i = 0; i < order; i++){
+        coloring->rows[forbidden[colors[i]]++] = i;
+    }
+
+    free(forbidden);
+    free(colors);
+    free(transposeStart);
+    free(transposeRows);
+}
+
+void freeColoring(Coloring *coloring){
+
+    free(coloring->colorStart);
+    free(coloring->rows);
+
+    memset(coloring, 0, sizeof(Coloring));
+}
+
+double sweepDenseBlock(const Kernel *kernel, const double *Ma, int lda, const double *Mb,
+        int order, int start, int end, double omega, const double *x_current, double *x_next){
+
+    int i;
+    const double *row;
+    double sum, error;
+    double maxError = 0;
+
+    for(i = start; i < end; i++){
+        row = Ma + (size_t) i * lda;
+
+        // Other blocks and the rest of this one from the previous iteration,
+        // the rows of this block before i from this one. A[i][i] is 0
+        sum = kernel->dot(row, x_current, start)
+            + kernel->dot(row + start, x_next + start, i - start)
+            + kernel->dot(row + i, x_current + i, order - i);
+
+        x_next[i] = (1 - omega) * x_current[i] + omega * (Mb[i] - sum);
+
+        error = fabs((x_next[i] - x_current[i]) / x_next[i]);
+        if(error > maxError)
+            maxError = error;
+    }
+
+    return maxError;
+}
+
+double estimateOmega(const Kernel *kernel, const double *Ma, int lda, const CsrMatrix *sparse,
+        const Coloring *coloring, const double *Mb, int order){
+
+    int i, k, sweep;
+    double *x_current = (double*) calloc(order, sizeof(double));
+    double *x_next = (double*) calloc(order, sizeof(double));
+    double *temp;
+    double change, previous = 0;
+    double rate = 0;
+
+    for(sweep = 0; sweep < OMEGA_SWEEPS; sweep++){
+        change = 0;
+        if(sparse != NULL){
+            for(k = 0; k < order; k++){
+                i = coloring->rows[k];
+                change = fmax(change, relaxSparseRow(sparse, Mb, i, 1, x_current));
+            }
+        }
+        else{
+            change = sweepDenseBlock(kernel, Ma, lda, Mb, order, 0, order, 1, x_current, x_next);
+            temp = x_current;
+            x_current = x_next;
+            x_next = temp;
+        }
+
+        // Converged, the next ratios would be rounding noise
+        if(!(change > OMEGA_MIN_CHANGE))
+            break;
+
+        if(sweep > 0)
+            rate = change / previous;
+        previous = change;
+    }
+
+    free(x_current);
+    free(x_next);
+
+    if(!(rate < 1))
+        return 1;
+
+    if(rate > OMEGA_MAX_RATE)
+        rate = OMEGA_MAX_RATE;
+
+    return 2 / (1 + sqrt(1 - rate));
+}
@@ -0,0 +1,83 @@
+#ifndef RELAX_H
+#define RELAX_H
+
+#include <math.h>
+
+#include "kernels.h"
+#include "sparse.h"
+
+/**
+ * Gauss-Seidel and SOR sweeps over the prepared system
+ *
+ * prepareMatrices leaves A with a zero diagonal and every row divided by it,
+ * so the update of row i is simply
+ *
+ *   x[i] = (1 - omega) * x[i] + omega * (b[i] - sum(A[i][j] * x[j]))
+ *
+ * with omega = 1 for Gauss-Seidel. The newest value of each x[j] is used, so
+ * the rows can only be updated at the same time if they do not read each
+ * other:
+ *
+ * - Sparse matrices are split in colors (red-black for a 5-point stencil),
+ *   no two rows of a color share a non-zero, so each color is updated in
+ *   parallel and the colors one after the other.
+ * - In a dense matrix every row reads every other one, so each thread sweeps
+ *   its own block of rows Gauss-Seidel style and reads the rows of the other
+ *   blocks from the previous iteration. A single block is plain Gauss-Seidel,
+ *   the only sweep estimateOmega measures (see relaxationFactor).
+ */
+
+/**
+ * Rows of each color, color c owns rows[colorStart[c]] to
+ * rows[colorStart[c + 1] - 1], in increasing order
+ */
+typedef struct {
+
+    int colors;
+    int *colorStart;
+    int *rows;
+
+} Coloring;
+
+/**
+ * Greedy coloring of the rows of a sparse matrix: rows i and j get different
+ * colors when A[i][j] or A[j][i] is stored
+ */
+void colorRows(const CsrMatrix *matrix, Coloring *coloring);
+
+/**
+ * Free the arrays of the coloring
+ */
+void freeColoring(Coloring *coloring);
+
+/**
+ * Sweep the rows [start, end) of a dense matrix into x_next. Rows of the
+ * block already updated are read from x_next, every other row from
+ * x_current. Returns the max relative change of the block
+ */
+double sweepDenseBlock(const Kernel *kernel, const double *Ma, int lda, const double *Mb,
+        int order, int start, int end, double omega, const double *x_current, double *x_next);
+
+/**
+ * Update row i of a sparse matrix in place, returns its relative change
+ */
+static inline double relaxSparseRow(const CsrMatrix *matrix, const double *Mb, int i,
+        double omega, double *x){
+
+    double previous = x[i];
+
+    x[i] = (1 - omega) * previous + omega * (Mb[i] - csrRowDot(matrix, i, x));
+
+    return fabs((x[i] - previous) / x[i]);
+}
+
+/**
+ * Relaxation factor for SOR from the convergence rate of a few Gauss-Seidel
+ * sweeps: rho is the ratio between the changes of two consecutive sweeps and
+ * omega = 2 / (1 + sqrt(1 - rho)), the optimum for consistently ordered
+ * matrices. A Gauss-Seidel that converges fast gives an omega close to 1
+ */
+double estimateOmega(const Kernel *kernel, const double *Ma, int lda, const CsrMatrix *sparse,
+        const Coloring *coloring, const double *Mb, int order);
+
+#endif
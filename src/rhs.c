@@ -0,0 +1,111 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "rhs.h"
+
+void rhsStart(RhsSet *set, const double *Mb, int order, int count){
+
+    int c;
+    size_t size = (size_t) order * count;
+
+    set->order = order;
+    set->count = count;
+    set->active = count;
+    set->b = (double*) malloc(sizeof(double) * size);
+    set->solution = (double*) malloc(sizeof(double) * size);
+    set->column = (int*) malloc(sizeof(int) * count);
+    set->iterations = (int*) malloc(sizeof(int) * count);
+    set->errors = (double*) malloc(sizeof(double) * count);
+
+    memcpy(set->b, Mb, sizeof(double) * size);
+    for(c = 0; c < count; c++){
+        set->column[c] = c;
+    }
+}
+
+/**
+ * Copy column c of x to the solution of the right-hand side it holds
+ */
+static void saveColumn(RhsSet *set, const double *x, int c, int iterations){
+
+    int i;
+    int r = set->column[c];
+
+    for(i = 0; i < set->order; i++){
+        set->solution[(size_t) i * set->count + r] = x[(size_t) i * set->count + c];
+    }
+    set->iterations[r] = iterations;
+}
+
+/**
+ * Exchange columns c and d of an interleaved array
+ */
+static void swapColumns(double *x, int order, int count, int c, int d){
+
+    int i;
+    double temp;
+
+    for(i = 0; i < order; i++){
+        temp = x[(size_t) i * count + c];
+        x[(size_t) i * count + c] = x[(size_t) i * count + d];
+        x[(size_t) i * count + d] = temp;
+    }
+}
+
+int rhsRetire(RhsSet *set, double *x, double error, int iterations){
+
+    int c, last, temp;
+
+    // From the last column down, the one moved in has already been checked
+    for(c = set->active - 1; c >= 0; c--){
+        if(set->errors[c] > error)
+            continue;
+
+        saveColumn(set, x, c, iterations);
+
+        last = set->active - 1;
+        if(c != last){
+            swapColumns(x, set->order, set->count, c, last);
+            swapColumns(set->b, set->order, set->count, c, last);
+            temp = set->column[c];
+            set->column[c] = set->column[last];
+            set->column[last] = temp;
+            set->errors[c] = set->errors[last];
+        }
+        set->active--;
+    }
+
+    return set->active;
+}
+
+void rhsFinish(RhsSet *set, const double *x, int iterations){
+
+    int c;
+
+    for(c = 0; c < set->active; c++){
+        saveColumn(set, x, c, iterations);
+    }
+}
+
+double rhsRowTest(const RhsSet *set, const double *row, int r){
+
+    int i;
+    double result = 0;
+
+    for(i = 0; i < set->order; i++){
+        result = result + row[i] * set->solution[(size_t) i * set->count + r];
+    }
+
+    return result;
+}
+
+void rhsFree(RhsSet *set){
+
+    free(set->b);
+    free(set->solution);
+    free(set->column);
+    free(set->iterations);
+    free(set->errors);
+
+    memset(set, 0, sizeof(RhsSet));
+}
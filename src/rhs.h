@@ -0,0 +1,62 @@
+#ifndef RHS_H
+#define RHS_H
+
+/**
+ * Bookkeeping of a solve with several right-hand sides
+ *
+ * The x vectors of every right-hand side are interleaved, value i of the
+ * vector held by column c is at x[i * count + c], so a single pass over the
+ * rows of Matrix A updates all of them. Only the first `active` columns are
+ * computed: once a right-hand side converges its x is saved and the last
+ * active column is moved to its place.
+ *
+ * order: Matrix order
+ * count: Number of right-hand sides
+ * active: Columns still iterating
+ * *b: Working copy of the interleaved Array B, permuted with the columns
+ * *solution: Final x of every right-hand side, in the original order
+ * *column: Right-hand side held by each column
+ * *iterations: Iterations each right-hand side took to converge
+ * *errors: Error of each active column in the last iteration
+ */
+typedef struct {
+
+    int order;
+    int count;
+    int active;
+    double *b;
+    double *solution;
+    int *column;
+    int *iterations;
+    double *errors;
+
+} RhsSet;
+
+/**
+ * Start a solve of count right-hand sides, Mb is the prepared Array B
+ */
+void rhsStart(RhsSet *set, const double *Mb, int order, int count);
+
+/**
+ * Save and remove the columns whose error is not above J_ERROR. x is the
+ * newest iterate, its active columns are permuted together with b.
+ * Returns the number of columns still active
+ */
+int rhsRetire(RhsSet *set, double *x, double error, int iterations);
+
+/**
+ * Save the columns still active when the solve stops at J_ITE_MAX
+ */
+void rhsFinish(RhsSet *set, const double *x, int iterations);
+
+/**
+ * sum(row[i] * x[i]) for the final x of right-hand side r
+ */
+double rhsRowTest(const RhsSet *set, const double *row, int r);
+
+/**
+ * Free the arrays of the set
+ */
+void rhsFree(RhsSet *set);
+
+#endif
@@ -0,0 +1,281 @@
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include <stdio.h>
+
+#include "jacobi.h"
+#include "matrixio.h"
+#include "kernels.h"
+#include "options.h"
+#include "sparse.h"
+#include "relax.h"
+#include "stream.h"
+#include "checkpoint.h"
+#include "chebyshev.h"
+
+/**
+ * Internals of the solver library shared by problem.c, jacobi.c and the
+ * engines. Nothing here is exported, programs use jacobi.h
+ */
+
+typedef struct Engine Engine;
+
+/**
+ * Structure that hold all the information about the problem, the JrProblem of
+ * jacobi.h
+ * J_ORDER : Matrix Order
+ * J_ROW_TEST: Row that will be used to test the result
+ * J_ERROR: Error value acceptable
+ * J_ITE_MAX: Max number of iterations allowed
+ * *Ma: Matrix A, row i starts at Ma + i * lda (64-byte aligned)
+ * lda: Leading dimension of Matrix A, J_ORDER padded to a cache line
+ * *Mb: Pointer to the array B, rhsCount right-hand sides interleaved (value
+ * i of right-hand side r at Mb[i * rhsCount + r])
+ * rhsCount: Number of right-hand sides, more than one with --rhs
+ * *testedB: Original value of Array B at J_ROW_TEST for each right-hand side
+ * mapped: Binary file backing Ma and Mb, if the input was a binary matrix
+ * prepared: Ma and Mb were already divided by the main diagonal
+ * sparse: Matrix A in CSR format when it is sparse enough, Ma is NULL then
+ * *MaFloat: Prepared Matrix A stored as float (--precision mixed), with its
+ * own leading dimension ldaFloat
+ * useFloat: The sweep reads MaFloat instead of Ma
+ * omega: Relaxation factor of Gauss-Seidel (1) and SOR
+ * spectrum: Estimated eigenvalues of -(L* + R*), used by Chebyshev
+ * acceleration
+ * coloring: Order of the Gauss-Seidel and SOR updates of a sparse matrix
+ * engine: Engine that places, prepares and solves this problem
+ * stream: Matrix A read from the file block by block (--out-of-core), Ma is
+ * NULL then
+ * checkpoint: Where the Jacobi-Richardson solves save their iterate
+ * (--checkpoint), NULL without it
+ * initial: Initial guess of the solves (--initial, jrSetInitial), NULL
+ * starts from x = 0
+ * solution: x of the last solve, NULL before the first one
+ */
+typedef struct JrProblem {
+
+    int J_ORDER;
+    int J_ROW_TEST;
+    double J_ERROR;
+    int J_ITE_MAX;
+    double *testedRow;
+    double *testedB;
+    int rhsCount;
+    double *Ma;
+    int lda;
+    double *Mb;
+    MappedMatrix mapped;
+    int prepared;
+    CsrMatrix *sparse;
+    float *MaFloat;
+    int ldaFloat;
+    int useFloat;
+    double omega;
+    Spectrum spectrum;
+    Coloring *coloring;
+    const Engine *engine;
+    StreamMatrix *stream;
+    Checkpoint *checkpoint;
+    double *initial;
+    double *solution;
+
+} Data;
+
+/**
+ * Way of running the sweeps, one per program the solver started as
+ *
+ * name: Value of --engine, also written to the output file
+ * start: Create and pin (--pin) the threads of the engine. Called once,
+ * before the first problem using the engine is read, it writes its own
+ * lines (Barrier, Topology) to the output file
+ * placeRows: Touch the rows of a Matrix A from reserveMatrix on the threads
+ * that will sweep them
+ * prepareRows: Divide each row of a dense Matrix A and Array B by the main
+ * diagonal
+ * solve: Solve once from startIterate with options.method, setting iterations,
+ * rowTestResult and timeSpent and writing the solve to the output file
+ * threads: Number of threads the solves run on
+ * resize: Run the next solves on numberOfThreads threads, NULL if the
+ * engine has a single one
+ * stop: Release everything created by start
+ */
+struct Engine {
+
+    const char *name;
+    void (*start)(void);
+    void (*placeRows)(Data *data);
+    void (*prepareRows)(Data *data);
+    void (*solve)(Data *data);
+    int (*threads)(void);
+    void (*resize)(int numberOfThreads);
+    void (*stop)(void);
+
+};
+
+extern const Engine serialEngine;
+extern const Engine pthreadEngine;
+extern const Engine openmpEngine;
+
+/**
+ * For the sake of simplicity the state of the library is global, set once by
+ * jrInit
+ */
+
+// Options given to jrInit
+extern Options options;
+
+// Where the solves are reported
+extern FILE *outputFile;
+
+// Dot product kernel picked at runtime for this CPU
+extern const Kernel *kernel;
+
+// Cache blocking of the dense sweep, sized for this CPU
+extern Blocking blocking;
+
+// Iterations, value computed for J_ROW_TEST and time of the last solve
+extern int iterations;
+extern double rowTestResult;
+extern double timeSpent;
+
+/**
+ * Engine for a loaded problem according to --engine, started if it is the
+ * first time it is used
+ */
+const Engine* useEngine(Data *data);
+
+/**
+ * Rows [start, end) of thread t out of numberOfThreads for a matrix of the
+ * given order, according to options.partition
+ */
+void rowBlock(int order, int numberOfThreads, int t, int *start, int *end);
+
+/**
+ * Read data from file.
+ * file: The pointer to the file that contains the data
+ * *data: Pointer that will hold the information gathered, zeroed
+ */
+int readFromFile(FILE* file, Data *data);
+
+/**
+ * Read a text matrix (see textparse.h)
+ */
+int readFromText(FILE* file, Data *data);
+
+/**
+ * Replace Array B with the right-hand sides of the --rhs file
+ */
+int readRightHandSides(Data *data);
+
+/**
+ * Map the metadata and Array B of a prepared binary matrix and stream its
+ * Matrix A (--out-of-core)
+ */
+int readOutOfCore(FILE* file, Data *data);
+
+/**
+ * Map a binary matrix (see matrixio.h) instead of parsing it. The rows of
+ * Matrix A and the Array B point straight into the mapping
+ */
+int readFromBinary(FILE* file, Data *data);
+
+/**
+ * Read a sparse Matrix Market file into CSR. The metadata and the Array B
+ * come from the command line (see options.h)
+ */
+int readFromMatrixMarket(FILE* file, Data *data);
+
+/**
+ * Estimate the spectrum of a prepared problem for --method chebyshev.
+ * Returns 0 on success
+ */
+int prepareChebyshev(Data *data);
+
+/**
+ * Starting point of a solve of a single right-hand side: the initial guess,
+ * or 0 without one
+ */
+void startIterate(Data *data, double *x);
+
+/**
+ * Keep the final x of a solve of a single right-hand side in data->solution
+ */
+void keepSolution(Data *data, const double *x);
+
+/**
+ * Storage of Matrix A: "dense", "sparse" or "out-of-core"
+ */
+const char* storageName(Data *data);
+
+/**
+ * Write the storage used for Matrix A to the output file
+ */
+void printStorage(Data *data);
+
+/**
+ * Pick dense or sparse (CSR) storage for Matrix A according to its density
+ * and the --storage option, converting it if needed
+ */
+int chooseStorage(Data *data);
+
+/**
+ * Floating point operations and bytes of memory traffic of one iteration:
+ * a multiply and an add per value of Matrix A and right-hand side, Matrix A
+ * read once for all the right-hand sides and x and Array B streamed. A model
+ * of the sweep that ignores the caches, for the GFLOP/s and bandwidth of
+ * the benchmark
+ */
+void sweepCost(Data *data, double *flops, double *bytes);
+
+/**
+ * It prints all the metadata, Matrix A, and Array B
+ *
+ */
+void printData(Data data);
+
+/**
+ * Free all the memory allocated for the data strucute
+ *
+ */
+void freeData(Data *data);
+
+/**
+ * Preapre the Matrix A and the Array B
+ *
+ * When using the Jacobi-Richardson method we have A* = L* + I* + R* where
+ * A* is the matrix A by its main diagonal
+ *
+ * We have to perform the same calculation for the Array B. A dense matrix is
+ * scaled by the engine, so each thread scales the rows it sweeps
+ *
+ */
+void prepareMatrices(Data *data);
+
+/**
+ * Copy the prepared Matrix A to MaFloat and make the sweep use it. The
+ * double copy is released unless keepDouble is set (or it is mapped)
+ */
+void storeAsFloat(Data *data, int keepDouble);
+
+/**
+ * Get the matrix ready for Gauss-Seidel or SOR: color the rows of a sparse
+ * matrix and pick omega (--omega or estimateOmega)
+ */
+int prepareRelaxation(Data *data);
+
+/**
+ * Relaxation factor of a dense sweep split in the given number of blocks.
+ * estimateOmega measures a single Gauss-Seidel sweep, between blocks the
+ * update is Jacobi and over-relaxing it can diverge, so an estimated omega
+ * falls back to 1 with several blocks. --omega is always used as given
+ */
+double relaxationFactor(Data *data, int blocks);
+
+/**
+ * Solve once with the double Matrix A and once with the float one, then
+ * compare the iterations and the RowTest value. Only the mixed solve is left
+ * in timeSpent. Returns 1 if they do not agree
+ */
+int checkPrecision(Data *data);
+
+#endif
@@ -0,0 +1,458 @@
+#include <stdio.h>
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "sparse.h"
+#include "matrixio.h"
+#include "textparse.h"
+
+#define MM_BANNER "%%MatrixMarket"
+
+/**
+ * A file mapped in memory, p is the current reading position
+ */
+typedef struct {
+
+    const char *text;
+    const char *p;
+    const char *end;
+    size_t size;
+
+} MappedText;
+
+static int mapText(int fd, MappedText *mapped){
+
+    struct stat st;
+
+    memset(mapped, 0, sizeof(MappedText));
+
+    if(fstat(fd, &st) != 0 || st.st_size == 0)
+        return 1;
+
+    mapped->size = st.st_size;
+    mapped->text = (const char*) mmap(NULL, mapped->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if(mapped->text == MAP_FAILED){
+        mapped->text = NULL;
+        return 1;
+    }
+
+    madvise((void*) mapped->text, mapped->size, MADV_SEQUENTIAL);
+    mapped->p = mapped->text;
+    mapped->end = mapped->text + mapped->size;
+
+    return 0;
+}
+
+static void unmapText(MappedText *mapped){
+
+    if(mapped->text != NULL)
+        munmap((void*) mapped->text, mapped->size);
+
+    memset(mapped, 0, sizeof(MappedText));
+}
+
+static void skipLine(MappedText *mapped){
+
+    while(mapped->p < mapped->end && *mapped->p != '\n')
+        mapped->p++;
+
+    if(mapped->p < mapped->end)
+        mapped->p++;
+}
+
+/**
+ * Skip whitespace and every line starting with %
+ */
+static void skipComments(MappedText *mapped){
+
+    for(;;){
+        while(mapped->p < mapped->end && isspace((unsigned char) *mapped->p))
+            mapped->p++;
+
+        if(mapped->p < mapped->end && *mapped->p == '%')
+            skipLine(mapped);
+        else
+            return;
+    }
+}
+
+/**
+ * Next whitespace separated value
+ */
+static int nextValue(MappedText *mapped, double *value){
+
+    size_t n;
+
+    while(mapped->p < mapped->end && isspace((unsigned char) *mapped->p))
+        mapped->p++;
+
+    n = parseDouble(mapped->p, mapped->end, value);
+    if(n == 0)
+        return 1;
+
+    mapped->p += n;
+
+    return 0;
+}
+
+/**
+ * Read the banner line, in lower case: %%MatrixMarket object format field symmetry
+ */
+static int readBanner(MappedText *mapped, char words[5][32]){
+
+    char line[256];
+    size_t length = 0;
+    int i;
+
+    while(mapped->p + length < mapped->end && mapped->p[length] != '\n' && length < sizeof(line) - 1){
+        line[length] = tolower((unsigned char) mapped->p[length]);
+        length++;
+    }
+    line[length] = '\0';
+    skipLine(mapped);
+
+    for(i = 0; i < 5; i++){
+        words[i][0] = '\0';
+    }
+
+    return sscanf(line, "%31s %31s %31s %31s %31s", words[0], words[1], words[2], words[3], words[4]);
+}
+
+int isMatrixMarket(FILE *file){
+
+    char banner[sizeof(MM_BANNER) - 1];
+    long position = ftell(file);
+    size_t n = fread(banner, 1, sizeof(banner), file);
+
+    fseek(file, position, SEEK_SET);
+
+    return n == sizeof(banner) && memcmp(banner, MM_BANNER, sizeof(banner)) == 0;
+}
+
+int readMatrixMarket(FILE *file, CsrMatrix *matrix){
+
+    size_t k, entries, stored;
+    size_t *count;
+    int *rows, *columns;
+    double *values;
+    double header[3], value[3];
+    int pattern, symmetric, skew;
+    char words[5][32];
+    MappedText mapped;
+
+    memset(matrix, 0, sizeof(CsrMatrix));
+
+    if(mapText(fileno(file), &mapped) != 0){
+        fprintf(stderr, "Matrix Market: empty or unreadable file\n");
+        return 1;
+    }
+
+    if(readBanner(&mapped, words) != 5 || strcmp(words[1], "matrix") != 0 ||
+            strcmp(words[2], "coordinate") != 0 || strcmp(words[3], "complex") == 0 ||
+            strcmp(words[4], "hermitian") == 0){
+        fprintf(stderr, "Matrix Market: only real coordinate matrices are supported\n");
+        unmapText(&mapped);
+        return 1;
+    }
+
+    pattern = strcmp(words[3], "pattern") == 0;
+    skew = strcmp(words[4], "skew-symmetric") == 0;
+    symmetric = skew || strcmp(words[4], "symmetric") == 0;
+
+    // rows columns entries
+    skipComments(&mapped);
+    if(nextValue(&mapped, &header[0]) || nextValue(&mapped, &header[1]) ||
+            nextValue(&mapped, &header[2]) || header[0] != header[1] || header[0] <= 0){
+        fprintf(stderr, "Matrix Market: the matrix must be square\n");
+        unmapText(&mapped);
+        return 1;
+    }
+
+    matrix->order = (int) header[0];
+    entries = (size_t) header[2];
+
+    // Coordinates first, symmetric files store only one triangle
+    rows = (int*) malloc(sizeof(int) * entries * (symmetric ? 2 : 1));
+    columns = (int*) malloc(sizeof(int) * entries * (symmetric ? 2 : 1));
+    values = (double*) malloc(sizeof(double) * entries * (symmetric ? 2 : 1));
+
+    stored = 0;
+    for(k = 0; k < entries; k++){
+        if(nextValue(&mapped, &value[0]) || nextValue(&mapped, &value[1]) ||
+                (!pattern && nextValue(&mapped, &value[2])) ||
+                value[0] < 1 || value[0] > matrix->order ||
+                value[1] < 1 || value[1] > matrix->order){
+            fprintf(stderr, "Matrix Market: invalid entry %zu\n", k + 1);
+            free(rows);
+            free(columns);
+            free(values);
+            unmapText(&mapped);
+            return 1;
+        }
+
+        rows[stored] = (int) value[0] - 1;
+        columns[stored] = (int) value[1] - 1;
+        values[stored] = pattern ? 1 : value[2];
+        stored++;
+
+        if(symmetric && value[0] != value[1]){
+            rows[stored] = columns[stored - 1];
+            columns[stored] = rows[stored - 1];
+            values[stored] = skew ? -values[stored - 1] : values[stored - 1];
+            stored++;
+        }
+    }
+    unmapText(&mapped);
+
+    // Counting sort of the coordinates by row
+    matrix->nnz = stored;
+    matrix->rowStart = (size_t*) calloc(matrix->order + 1, sizeof(size_t));
+    matrix->columns = (int*) malloc(sizeof(int) * stored);
+    matrix->values = (double*) malloc(sizeof(double) * stored);
+
+    for(k = 0; k < stored; k++){
+        matrix->rowStart[rows[k] + 1]++;
+    }
+    for(k = 0; k < (size_t) matrix->order; k++){
+        matrix->rowStart[k + 1] += matrix->rowStart[k];
+    }
+
+    count = (size_t*) malloc(sizeof(size_t) * matrix->order);
+    memcpy(count, matrix->rowStart, sizeof(size_t) * matrix->order);
+    for(k = 0; k < stored; k++){
+        matrix->columns[count[rows[k]]] = columns[k];
+        matrix->values[count[rows[k]]] = values[k];
+        count[rows[k]]++;
+    }
+
+    free(count);
+    free(rows);
+    free(columns);
+    free(values);
+
+    return 0;
+}
+
+int readVectors(const char *path, int order, int *count, double **values){
+
+    size_t i, total, capacity = order;
+    double size[2];
+    double value;
+    double *read;
+    char words[5][32];
+    MappedText mapped;
+    FILE *file = fopen(path, "r");
+
+    if(file == NULL || mapText(fileno(file), &mapped) != 0){
+        fprintf(stderr, "%s: empty or unreadable file\n", path);
+        if(file != NULL)
+            fclose(file);
+        return 1;
+    }
+    fclose(file);
+
+    // A Matrix Market array has a "rows columns" line before the values
+    if(mapped.size >= sizeof(MM_BANNER) - 1 && memcmp(mapped.text, MM_BANNER, sizeof(MM_BANNER) - 1) == 0){
+        if(readBanner(&mapped, words) < 3 || strcmp(words[2], "array") != 0){
+            fprintf(stderr, "%s: only Matrix Market arrays are supported\n", path);
+            unmapText(&mapped);
+            return 1;
+        }
+
+        skipComments(&mapped);
+        if(nextValue(&mapped, &size[0]) || nextValue(&mapped, &size[1]) ||
+                size[0] != order || size[1] < 1){
+            fprintf(stderr, "%s: expected %d rows\n", path, order);
+            unmapText(&mapped);
+            return 1;
+        }
+        capacity = (size_t) order * (size_t) size[1];
+    }
+
+    // Every value up to the end of the file, one vector after the other
+    read = (double*) malloc(sizeof(double) * capacity);
+    total = 0;
+    for(;;){
+        skipComments(&mapped);
+        if(mapped.p >= mapped.end)
+            break;
+
+        if(nextValue(&mapped, &value)){
+            fprintf(stderr, "%s: invalid value %zu\n", path, total + 1);
+            free(read);
+            unmapText(&mapped);
+            return 1;
+        }
+
+        if(total == capacity){
+            capacity = capacity * 2;
+            read = (double*) realloc(read, sizeof(double) * capacity);
+        }
+        read[total++] = value;
+    }
+    unmapText(&mapped);
+
+    if(total == 0 || total % order != 0){
+        fprintf(stderr, "%s: expected a multiple of %d values\n", path, order);
+        free(read);
+        return 1;
+    }
+
+    // Interleave the vectors, the sweep reads the same row of all of them
+    *count = total / order;
+    *values = (double*) malloc(sizeof(double) * total);
+    for(i = 0; i < total; i++){
+        (*values)[(i % order) * *count + i / order] = read[i];
+    }
+    free(read);
+
+    return 0;
+}
+
+int writeVector(const char *path, const double *values, int order){
+
+    int i;
+    FILE *file = fopen(path, "w");
+
+    if(file == NULL){
+        fprintf(stderr, "Could not open %s\n", path);
+        return 1;
+    }
+
+    // %.17g is enough to read back the same doubles
+    fprintf(file, "%s matrix array real general\n%d 1\n", MM_BANNER, order);
+    for(i = 0; i < order; i++){
+        fprintf(file, "%.17g\n", values[i]);
+    }
+
+    if(fclose(file) != 0){
+        fprintf(stderr, "Could not write %s\n", path);
+        return 1;
+    }
+
+    return 0;
+}
+
+size_t countNonZeros(const double *A, int lda, int order){
+
+    int i, j;
+    size_t nnz = 0;
+
+    for(i = 0; i < order; i++){
+        for(j = 0; j < order; j++){
+            nnz += A[(size_t) i * lda + j] != 0;
+        }
+    }
+
+    return nnz;
+}
+
+void denseToCsr(const double *A, int lda, int order, CsrMatrix *matrix){
+
+    int i, j;
+    size_t k = 0;
+    const double *row;
+
+    matrix->order = order;
+    matrix->nnz = countNonZeros(A, lda, order);
+    matrix->rowStart = (size_t*) malloc(sizeof(size_t) * (order + 1));
+    matrix->columns = (int*) malloc(sizeof(int) * matrix->nnz);
+    matrix->values = (double*) malloc(sizeof(double) * matrix->nnz);
+
+    for(i = 0; i < order; i++){
+        matrix->rowStart[i] = k;
+        row = A + (size_t) i * lda;
+        for(j = 0; j < order; j++){
+            if(row[j] != 0){
+                matrix->columns[k] = j;
+                matrix->values[k] = row[j];
+                k++;
+            }
+        }
+    }
+    matrix->rowStart[order] = k;
+}
+
+double* csrToDense(const CsrMatrix *matrix, int *lda){
+
+    int i;
+    size_t k;
+    double *A = allocateMatrix(matrix->order, lda);
+
+    if(A == NULL)
+        return NULL;
+
+    for(i = 0; i < matrix->order; i++){
+        memset(A + (size_t) i * *lda, 0, sizeof(double) * matrix->order);
+        for(k = matrix->rowStart[i]; k < matrix->rowStart[i + 1]; k++){
+            A[(size_t) i * *lda + matrix->columns[k]] += matrix->values[k];
+        }
+    }
+
+    return A;
+}
+
+void csrRow(const CsrMatrix *matrix, int i, double *row){
+
+    size_t k;
+
+    memset(row, 0, sizeof(double) * matrix->order);
+    for(k = matrix->rowStart[i]; k < matrix->rowStart[i + 1]; k++){
+        row[matrix->columns[k]] += matrix->values[k];
+    }
+}
+
+int csrPrepare(CsrMatrix *matrix, double *b, int count){
+
+    int i, r;
+    size_t k, kept = 0;
+    size_t start;
+    double currentDiagonal;
+
+    for(i = 0; i < matrix->order; i++){
+
+        // Find the diagonal of the row
+        currentDiagonal = 0;
+        for(k = matrix->rowStart[i]; k < matrix->rowStart[i + 1]; k++){
+            if(matrix->columns[k] == i)
+                currentDiagonal += matrix->values[k];
+        }
+
+        if(currentDiagonal == 0){
+            fprintf(stderr, "Row %d has no diagonal value\n", i);
+            return 1;
+        }
+
+        for(r = 0; r < count; r++){
+            b[(size_t) i * count + r] = b[(size_t) i * count + r] / currentDiagonal;
+        }
+
+        // Divide the row and compact it without the diagonal
+        start = matrix->rowStart[i];
+        matrix->rowStart[i] = kept;
+        for(k = start; k < matrix->rowStart[i + 1]; k++){
+            if(matrix->columns[k] != i){
+                matrix->columns[kept] = matrix->columns[k];
+                matrix->values[kept] = matrix->values[k] / currentDiagonal;
+                kept++;
+            }
+        }
+    }
+    matrix->rowStart[matrix->order] = kept;
+    matrix->nnz = kept;
+
+    return 0;
+}
+
+void freeCsr(CsrMatrix *matrix){
+
+    free(matrix->rowStart);
+    free(matrix->columns);
+    free(matrix->values);
+
+    memset(matrix, 0, sizeof(CsrMatrix));
+}
@@ -0,0 +1,127 @@
+#ifndef SPARSE_H
+#define SPARSE_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+/**
+ * Matrix A in compressed sparse row (CSR) format
+ *
+ * order: Matrix order
+ * nnz: Number of stored values
+ * rowStart: The values of row i are [rowStart[i], rowStart[i + 1])
+ * columns/values: Column and value of each stored entry
+ */
+typedef struct {
+
+    int order;
+    size_t nnz;
+    size_t *rowStart;
+    int *columns;
+    double *values;
+
+} CsrMatrix;
+
+/**
+ * Check whether the file starts with the Matrix Market banner. The file
+ * position is restored before returning.
+ */
+int isMatrixMarket(FILE *file);
+
+/**
+ * Read a Matrix Market coordinate file (real, integer or pattern; general,
+ * symmetric or skew-symmetric) into CSR. Symmetric files are expanded.
+ * Returns 0 on success, 1 on failure (a message is printed to stderr)
+ */
+int readMatrixMarket(FILE *file, CsrMatrix *matrix);
+
+/**
+ * Read one or more right-hand sides of J_ORDER values: either a Matrix Market
+ * array (J_ORDER x count) or plain whitespace separated values, one vector
+ * after the other. Lines starting with % are skipped. *values is allocated
+ * with the vectors interleaved, value i of vector r at i * count + r.
+ * Returns 0 on success, 1 on failure
+ */
+int readVectors(const char *path, int order, int *count, double **values);
+
+/**
+ * Write a vector of order values as a Matrix Market array, readable by
+ * readVectors. Returns 0 on success, 1 on failure
+ */
+int writeVector(const char *path, const double *values, int order);
+
+/**
+ * Number of non-zero values of a dense matrix
+ */
+size_t countNonZeros(const double *A, int lda, int order);
+
+/**
+ * Build the CSR version of a dense matrix
+ */
+void denseToCsr(const double *A, int lda, int order, CsrMatrix *matrix);
+
+/**
+ * Expand a CSR matrix to a dense J_ORDER x lda block, see allocateMatrix
+ * Returns NULL if the allocation fails
+ */
+double* csrToDense(const CsrMatrix *matrix, int *lda);
+
+/**
+ * Copy row i of the matrix to a dense array of J_ORDER values
+ */
+void csrRow(const CsrMatrix *matrix, int i, double *row);
+
+/**
+ * Same as prepareMatrices: divide every row and b by the main diagonal and
+ * drop the diagonal entries. b holds count interleaved right-hand sides.
+ * Returns 1 if a diagonal entry is missing or zero
+ */
+int csrPrepare(CsrMatrix *matrix, double *b, int count);
+
+/**
+ * sum(A[i][j] * x[j]) over the stored values of row i
+ */
+static inline double csrRowDot(const CsrMatrix *matrix, int i, const double *x){
+
+    size_t k;
+    size_t end = matrix->rowStart[i + 1];
+    double result = 0;
+
+    for(k = matrix->rowStart[i]; k < end; k++){
+        result = result + matrix->values[k] * x[matrix->columns[k]];
+    }
+
+    return result;
+}
+
+/**
+ * Row i times count interleaved vectors, see MultiDotKernel in kernels.h
+ */
+static inline void csrRowMultiDot(const CsrMatrix *matrix, int i, const double *X,
+        int ldx, int count, double *result){
+
+    size_t k;
+    size_t end = matrix->rowStart[i + 1];
+    int r;
+    double value;
+    const double *x;
+
+    for(r = 0; r < count; r++){
+        result[r] = 0;
+    }
+
+    for(k = matrix->rowStart[i]; k < end; k++){
+        value = matrix->values[k];
+        x = X + (size_t) matrix->columns[k] * ldx;
+        for(r = 0; r < count; r++){
+            result[r] = result[r] + value * x[r];
+        }
+    }
+}
+
+/**
+ * Free the arrays of the matrix
+ */
+void freeCsr(CsrMatrix *matrix);
+
+#endif
@@ -0,0 +1,213 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "stream.h"
+#include "options.h"
+
+/**
+ * Read the rows of a block into buffer. Returns 0 on success, 1 on failure
+ */
+static int readBlock(StreamMatrix *stream, int block, double *buffer){
+
+    int first = block * stream->blockRows;
+    int rows = stream->order - first < stream->blockRows ? stream->order - first : stream->blockRows;
+    size_t length = (size_t) rows * stream->lda * sizeof(double);
+    off_t offset = stream->aOffset + (size_t) first * stream->lda * sizeof(double);
+    size_t done = 0;
+    ssize_t n;
+
+    while(done < length){
+        n = pread(stream->fd, (char*) buffer + done, length - done, offset + done);
+        if(n < 0 && errno == EINTR)
+            continue;
+        if(n < 0){
+            perror("Out-of-core Matrix A: pread");
+            return 1;
+        }
+        if(n == 0){
+            fprintf(stderr, "Out-of-core Matrix A: file shorter than header says\n");
+            return 1;
+        }
+        done = done + n;
+    }
+
+    // Read once per iteration, no point in keeping it cached
+    posix_fadvise(stream->fd, offset, length, POSIX_FADV_DONTNEED);
+
+    return 0;
+}
+
+/**
+ * Reader thread, fills the buffers in turn until streamStop
+ */
+static void* readBlocks(void *rawStream){
+
+    StreamMatrix *stream = (StreamMatrix*) rawStream;
+    long sequence;
+    int buffer, block, rows, stop, failed;
+    double seconds, bytes;
+    struct timespec start, finish;
+
+    for(sequence = 0; ; sequence++){
+        buffer = sequence % 2;
+        block = sequence % stream->blocks;
+
+        pthread_mutex_lock(&stream->mutex);
+        while(stream->filled[buffer] != -1 && !stream->stop)
+            pthread_cond_wait(&stream->changed, &stream->mutex);
+        stop = stream->stop;
+        pthread_mutex_unlock(&stream->mutex);
+
+        if(stop)
+            break;
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        failed = readBlock(stream, block, stream->buffers[buffer]);
+        clock_gettime(CLOCK_MONOTONIC, &finish);
+
+        // The solve can not go on without its rows, the consumers stop
+        if(failed){
+            pthread_mutex_lock(&stream->mutex);
+            stream->failed = 1;
+            pthread_cond_broadcast(&stream->changed);
+            pthread_mutex_unlock(&stream->mutex);
+            break;
+        }
+
+        seconds = elapsedTime(start, finish);
+        rows = stream->order - block * stream->blockRows;
+        if(rows > stream->blockRows)
+            rows = stream->blockRows;
+
+        pthread_mutex_lock(&stream->mutex);
+        stream->filled[buffer] = sequence;
+        stream->readTime = stream->readTime + seconds;
+        stream->bytesRead = stream->bytesRead + (double) rows * stream->lda * sizeof(double);
+        stream->iterationTime = stream->iterationTime + seconds;
+
+        // Throughput of each iteration, once all of its blocks are in
+        if(block == stream->blocks - 1){
+            bytes = (double) stream->order * stream->lda * sizeof(double);
+            if(stream->iterationTime > 0){
+                if(stream->slowest == 0 || bytes / stream->iterationTime < stream->slowest)
+                    stream->slowest = bytes / stream->iterationTime;
+                if(bytes / stream->iterationTime > stream->fastest)
+                    stream->fastest = bytes / stream->iterationTime;
+            }
+            stream->iterationTime = 0;
+        }
+        pthread_cond_broadcast(&stream->changed);
+        pthread_mutex_unlock(&stream->mutex);
+    }
+
+    return NULL;
+}
+
+int streamOpen(StreamMatrix *stream, int fd, const BinaryHeader *header, size_t blockBytes){
+
+    size_t rowBytes = (size_t) header->lda * sizeof(double);
+
+    stream->order = header->order;
+    stream->lda = header->lda;
+    stream->aOffset = header->aOffset;
+
+    stream->blockRows = blockBytes / rowBytes;
+    if(stream->blockRows < 1)
+        stream->blockRows = 1;
+    if(stream->blockRows > stream->order)
+        stream->blockRows = stream->order;
+    stream->blocks = (stream->order + stream->blockRows - 1) / stream->blockRows;
+
+    stream->buffers[0] = NULL;
+    stream->buffers[1] = NULL;
+    if(posix_memalign((void**) &stream->buffers[0], 64, rowBytes * stream->blockRows) != 0 ||
+            posix_memalign((void**) &stream->buffers[1], 64, rowBytes * stream->blockRows) != 0){
+        fprintf(stderr, "Not enough memory for the out-of-core buffers\n");
+        free(stream->buffers[0]);
+        return 1;
+    }
+
+    stream->fd = dup(fd);
+    posix_fadvise(stream->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    pthread_mutex_init(&stream->mutex, NULL);
+    pthread_cond_init(&stream->changed, NULL);
+
+    return 0;
+}
+
+void streamStart(StreamMatrix *stream, int consumers){
+
+    stream->filled[0] = -1;
+    stream->filled[1] = -1;
+    stream->released[0] = 0;
+    stream->released[1] = 0;
+    stream->consumers = consumers;
+    stream->stop = 0;
+    stream->failed = 0;
+    stream->readTime = 0;
+    stream->bytesRead = 0;
+    stream->iterationTime = 0;
+    stream->slowest = 0;
+    stream->fastest = 0;
+    stream->waitTime = 0;
+
+    pthread_create(&stream->reader, NULL, &readBlocks, stream);
+}
+
+const double* streamAcquire(StreamMatrix *stream, long sequence){
+
+    int buffer = sequence % 2;
+    int filled;
+    struct timespec start, finish;
+
+    pthread_mutex_lock(&stream->mutex);
+    if(stream->filled[buffer] != sequence){
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        while(stream->filled[buffer] != sequence && !stream->failed)
+            pthread_cond_wait(&stream->changed, &stream->mutex);
+        clock_gettime(CLOCK_MONOTONIC, &finish);
+        stream->waitTime = stream->waitTime + elapsedTime(start, finish);
+    }
+    filled = stream->filled[buffer] == sequence;
+    pthread_mutex_unlock(&stream->mutex);
+
+    return filled ? stream->buffers[buffer] : NULL;
+}
+
+void streamRelease(StreamMatrix *stream, long sequence){
+
+    int buffer = sequence % 2;
+
+    pthread_mutex_lock(&stream->mutex);
+    stream->released[buffer]++;
+    if(stream->released[buffer] == stream->consumers){
+        stream->released[buffer] = 0;
+        stream->filled[buffer] = -1;
+        pthread_cond_broadcast(&stream->changed);
+    }
+    pthread_mutex_unlock(&stream->mutex);
+}
+
+void streamStop(StreamMatrix *stream){
+
+    pthread_mutex_lock(&stream->mutex);
+    stream->stop = 1;
+    pthread_cond_broadcast(&stream->changed);
+    pthread_mutex_unlock(&stream->mutex);
+
+    pthread_join(stream->reader, NULL);
+}
+
+void streamClose(StreamMatrix *stream){
+
+    pthread_mutex_destroy(&stream->mutex);
+    pthread_cond_destroy(&stream->changed);
+    close(stream->fd);
+    free(stream->buffers[0]);
+    free(stream->buffers[1]);
+}
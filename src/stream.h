@@ -0,0 +1,99 @@
+#ifndef STREAM_H
+#define STREAM_H
+
+#include <stddef.h>
+#include <pthread.h>
+
+#include "matrixio.h"
+
+/**
+ * Out-of-core Matrix A (--out-of-core)
+ *
+ * The rows of a prepared binary matrix (see matrixio.h) are read from the
+ * file in blocks of blockRows rows every iteration instead of being kept in
+ * memory. A reader thread fills two buffers in turn with pread, so the next
+ * block is on its way while the solver threads sweep the current one; only
+ * the buffers, x and Array B stay resident. The pages read are dropped from
+ * the page cache, a matrix larger than the memory does not push everything
+ * else out.
+ *
+ * Blocks are numbered by a sequence that keeps growing over the iterations,
+ * sequence s holds block s % blocks in buffer s % 2. Every consumer acquires
+ * each sequence and releases it when done; the buffer is refilled after the
+ * last consumer releases it.
+ *
+ * fd: The matrix file, read with pread
+ * aOffset/lda/order: Layout of Matrix A in the file
+ * blockRows/blocks: Rows per block and blocks per iteration
+ * buffers: Two blocks of blockRows x lda doubles
+ * filled: Sequence held by each buffer, -1 while it is free
+ * released: Consumers done with the sequence in each buffer
+ * consumers: Threads acquiring every sequence in the current solve
+ * stop: Set by streamStop, the reader quits
+ * failed: A pread failed, the reader quit and the blocks after it never come
+ * readTime/bytesRead: Time the reader spent in pread and bytes it read
+ * during the current solve
+ * iterationTime: Time spent in pread for the iteration being read
+ * slowest/fastest: Lowest and highest read throughput of a whole iteration,
+ * bytes per second
+ * waitTime: Time the consumers spent waiting for a block, summed over them
+ */
+typedef struct {
+
+    int fd;
+    size_t aOffset;
+    int lda;
+    int order;
+    int blockRows;
+    int blocks;
+    double *buffers[2];
+    long filled[2];
+    int released[2];
+    int consumers;
+    int stop;
+    int failed;
+    pthread_t reader;
+    pthread_mutex_t mutex;
+    pthread_cond_t changed;
+    double readTime;
+    double bytesRead;
+    double iterationTime;
+    double slowest;
+    double fastest;
+    double waitTime;
+
+} StreamMatrix;
+
+/**
+ * Stream the Matrix A of a binary file in blocks of about blockBytes bytes.
+ * The file descriptor is duplicated. Returns 0 on success, 1 on failure
+ */
+int streamOpen(StreamMatrix *stream, int fd, const BinaryHeader *header, size_t blockBytes);
+
+/**
+ * Start reading from block 0 for a solve with the given number of consumers
+ */
+void streamStart(StreamMatrix *stream, int consumers);
+
+/**
+ * Rows of the block of sequence, once they have been read. NULL if the
+ * reader failed before reading it, the same sequence for every consumer
+ */
+const double* streamAcquire(StreamMatrix *stream, long sequence);
+
+/**
+ * Called by every consumer when it is done with the block of sequence
+ */
+void streamRelease(StreamMatrix *stream, long sequence);
+
+/**
+ * Stop the reader at the end of a solve
+ */
+void streamStop(StreamMatrix *stream);
+
+/**
+ * Free the buffers and close the file
+ */
+void streamClose(StreamMatrix *stream);
+
+#endif
@@ -0,0 +1,423 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "textparse.h"
+
+// Chunks smaller than this are not worth a thread
+#define MIN_CHUNK_SIZE (256 * 1024)
+
+// Longest token handed to strtod when the fast path can not be used
+#define MAX_TOKEN 128
+
+/**
+ * Part of the body parsed by a single thread
+ *
+ * begin/end: Range of characters, both at whitespace boundaries
+ * first: Index of the first value of the chunk (A row by row, then B)
+ * count: Number of values in the chunk
+ * firstRow/rows: Rows of A stored, the others are skipped
+ */
+typedef struct {
+
+    const TextMatrix *matrix;
+    const char *begin;
+    const char *end;
+    size_t first;
+    size_t count;
+    double *A;
+    int lda;
+    int firstRow;
+    int rows;
+    double *b;
+    int failed;
+
+} ParseChunk;
+
+// Every power of ten up to 10^22 is exactly representable as a double
+static const double powersOfTen[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static int isSpace(char c){
+    return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+static int isDigit(char c){
+    return c >= '0' && c <= '9';
+}
+
+/**
+ * Slow path: copy the token and let strtod handle it (long mantissas, huge
+ * exponents, inf, nan). The solvers never call setlocale, so strtod runs in
+ * the "C" locale.
+ */
+static size_t parseDoubleSlow(const char *p, const char *end, double *value){
+
+    char token[MAX_TOKEN];
+    char *tokenEnd;
+    size_t length = 0;
+
+    while(p + length < end && !isSpace(p[length]) && length < MAX_TOKEN - 1){
+        token[length] = p[length];
+        length++;
+    }
+    token[length] = '\0';
+
+    *value = strtod(token, &tokenEnd);
+
+    return tokenEnd - token;
+}
+
+size_t parseDouble(const char *p, const char *end, double *value){
+
+    const char *start = p;
+    int negative = 0;
+    int digits = 0;
+    int exact = 1;
+    int sawDigit = 0;
+    int exponent = 0;
+    uint64_t mantissa = 0;
+
+    if(p < end && (*p == '-' || *p == '+')){
+        negative = *p == '-';
+        p++;
+    }
+
+    // Integer part, at most 19 significant digits fit in the mantissa
+    while(p < end && isDigit(*p)){
+        sawDigit = 1;
+        if(digits < 19){
+            mantissa = mantissa * 10 + (*p - '0');
+            if(mantissa != 0)
+                digits++;
+        }
+        else{
+            exponent++;
+            exact = 0;
+        }
+        p++;
+    }
+
+    // Fractional part
+    if(p < end && *p == '.'){
+        p++;
+        while(p < end && isDigit(*p)){
+            sawDigit = 1;
+            if(digits < 19){
+                mantissa = mantissa * 10 + (*p - '0');
+                if(mantissa != 0)
+                    digits++;
+                exponent--;
+            }
+            else if(*p != '0'){
+                exact = 0;
+            }
+            p++;
+        }
+    }
+
+    if(!sawDigit)
+        return parseDoubleSlow(start, end, value);
+
+    // Exponent, only consumed when it has at least one digit
+    if(p < end && (*p == 'e' || *p == 'E')){
+        const char *q = p + 1;
+        int exponentNegative = 0;
+        int explicitExponent = 0;
+
+        if(q < end && (*q == '-' || *q == '+')){
+            exponentNegative = *q == '-';
+            q++;
+        }
+
+        if(q < end && isDigit(*q)){
+            while(q < end && isDigit(*q)){
+                if(explicitExponent < 100000)
+                    explicitExponent = explicitExponent * 10 + (*q - '0');
+                q++;
+            }
+            exponent += exponentNegative ? -explicitExponent : explicitExponent;
+            p = q;
+        }
+    }
+
+    // Clinger's fast path: both the mantissa and the power of ten are exact
+    // doubles, so a single multiplication or division is correctly rounded
+    if(exact && mantissa <= (UINT64_C(1) << 53) && exponent >= -22 && exponent <= 22){
+        double result = (double) mantissa;
+
+        if(exponent < 0)
+            result = result / powersOfTen[-exponent];
+        else
+            result = result * powersOfTen[exponent];
+
+        *value = negative ? -result : result;
+        return p - start;
+    }
+
+    return parseDoubleSlow(start, end, value);
+}
+
+int loaderThreads(void){
+
+    const char *env = getenv("JR_LOAD_THREADS");
+    long threads;
+
+    if(env != NULL && atoi(env) > 0)
+        return atoi(env);
+
+    threads = sysconf(_SC_NPROCESSORS_ONLN);
+
+    return threads > 0 ? (int) threads : 1;
+}
+
+int openTextMatrix(int fd, TextMatrix *matrix){
+
+    struct stat st;
+    const char *p, *end;
+    double header[4];
+    size_t n;
+    int i;
+
+    memset(matrix, 0, sizeof(TextMatrix));
+
+    if(fstat(fd, &st) != 0 || st.st_size == 0){
+        fprintf(stderr, "Text matrix: empty or unreadable file\n");
+        return 1;
+    }
+
+    matrix->size = st.st_size;
+    matrix->text = (const char*) mmap(NULL, matrix->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if(matrix->text == MAP_FAILED){
+        perror("Text matrix: mmap");
+        matrix->text = NULL;
+        return 1;
+    }
+
+    // Every chunk is read right away by its own thread
+    madvise((void*) matrix->text, matrix->size, MADV_WILLNEED);
+
+    // J_ORDER J_ROW_TEST J_ERROR J_ITE_MAX
+    p = matrix->text;
+    end = matrix->text + matrix->size;
+    for(i = 0; i < 4; i++){
+        while(p < end && isSpace(*p))
+            p++;
+
+        n = parseDouble(p, end, &header[i]);
+        if(n == 0){
+            fprintf(stderr, "Text matrix: invalid header\n");
+            closeTextMatrix(matrix);
+            return 1;
+        }
+        p += n;
+    }
+
+    matrix->order = (int) header[0];
+    matrix->rowTest = (int) header[1];
+    matrix->error = header[2];
+    matrix->iteMax = (int) header[3];
+    matrix->bodyStart = p - matrix->text;
+
+    if(matrix->order <= 0 || matrix->rowTest < 0 || matrix->rowTest >= matrix->order){
+        fprintf(stderr, "Text matrix: invalid header\n");
+        closeTextMatrix(matrix);
+        return 1;
+    }
+
+    return 0;
+}
+
+void closeTextMatrix(TextMatrix *matrix){
+
+    if(matrix->text != NULL)
+        munmap((void*) matrix->text, matrix->size);
+
+    memset(matrix, 0, sizeof(TextMatrix));
+}
+
+/**
+ * First pass: count the values of the chunk
+ */
+static void* countChunk(void *rawChunk){
+
+    ParseChunk *chunk = (ParseChunk*) rawChunk;
+    const char *p = chunk->begin;
+
+    chunk->count = 0;
+    while(p < chunk->end){
+        while(p < chunk->end && isSpace(*p))
+            p++;
+
+        if(p == chunk->end)
+            break;
+
+        chunk->count++;
+        while(p < chunk->end && !isSpace(*p))
+            p++;
+    }
+
+    return NULL;
+}
+
+/**
+ * Second pass: parse the values of the chunk and store them in place
+ */
+static void* parseChunk(void *rawChunk){
+
+    ParseChunk *chunk = (ParseChunk*) rawChunk;
+    const char *p = chunk->begin;
+    size_t order = chunk->matrix->order;
+    size_t total = order * order + order;
+    size_t index = chunk->first;
+    size_t row = index / order;
+    size_t column = index % order;
+    size_t n;
+    double value;
+
+    while(p < chunk->end && index < total){
+        while(p < chunk->end && isSpace(*p))
+            p++;
+
+        if(p == chunk->end)
+            break;
+
+        // Rows kept by someone else are only skipped over
+        if(row < order && (row < (size_t) chunk->firstRow || row >= (size_t) (chunk->firstRow + chunk->rows))){
+            while(p < chunk->end && !isSpace(*p))
+                p++;
+        }
+        else{
+            n = parseDouble(p, chunk->end, &value);
+            if(n == 0 || (p + n < chunk->end && !isSpace(p[n]))){
+                chunk->failed = 1;
+                return NULL;
+            }
+            p += n;
+
+            if(row < order)
+                chunk->A[(row - chunk->firstRow) * chunk->lda + column] = value;
+            else
+                chunk->b[column] = value;
+        }
+
+        index++;
+        column++;
+        if(column == order){
+            column = 0;
+            row++;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Run the pass on every chunk, the first one on the calling thread
+ */
+static void runChunks(ParseChunk *chunks, int numberOfChunks, void* (*pass)(void*)){
+
+    int i;
+    pthread_t *threads = (pthread_t*) malloc(sizeof(pthread_t) * numberOfChunks);
+
+    for(i = 1; i < numberOfChunks; i++){
+        pthread_create(&threads[i], NULL, pass, &chunks[i]);
+    }
+
+    pass(&chunks[0]);
+
+    for(i = 1; i < numberOfChunks; i++){
+        pthread_join(threads[i], NULL);
+    }
+
+    free(threads);
+}
+
+int parseTextMatrix(const TextMatrix *matrix, double *A, int lda, double *b, int numberOfThreads){
+
+    return parseTextRows(matrix, 0, matrix->order, A, lda, b, numberOfThreads);
+}
+
+int parseTextRows(const TextMatrix *matrix, int firstRow, int rows, double *A, int lda,
+        double *b, int numberOfThreads){
+
+    int i;
+    int numberOfChunks;
+    int failed = 0;
+    size_t bodySize = matrix->size - matrix->bodyStart;
+    size_t chunkSize;
+    size_t first = 0;
+    size_t expected = (size_t) matrix->order * matrix->order + matrix->order;
+    const char *body = matrix->text + matrix->bodyStart;
+    const char *end = matrix->text + matrix->size;
+    const char *boundary;
+    ParseChunk *chunks;
+
+    numberOfChunks = bodySize / MIN_CHUNK_SIZE + 1;
+    if(numberOfChunks > numberOfThreads)
+        numberOfChunks = numberOfThreads;
+    if(numberOfChunks < 1)
+        numberOfChunks = 1;
+
+    chunks = (ParseChunk*) calloc(numberOfChunks, sizeof(ParseChunk));
+    chunkSize = bodySize / numberOfChunks;
+
+    // Split the body, moving every boundary forward until it reaches a
+    // whitespace so no value is cut in half
+    boundary = body;
+    for(i = 0; i < numberOfChunks; i++){
+        chunks[i].matrix = matrix;
+        chunks[i].A = A;
+        chunks[i].lda = lda;
+        chunks[i].firstRow = firstRow;
+        chunks[i].rows = rows;
+        chunks[i].b = b;
+        chunks[i].begin = boundary;
+
+        if(i == numberOfChunks - 1){
+            boundary = end;
+        }
+        else{
+            boundary = body + chunkSize * (i + 1);
+            if(boundary < chunks[i].begin)
+                boundary = chunks[i].begin;
+            while(boundary < end && !isSpace(*boundary))
+                boundary++;
+        }
+        chunks[i].end = boundary;
+    }
+
+    runChunks(chunks, numberOfChunks, countChunk);
+
+    // Prefix sum: index of the first value of each chunk
+    for(i = 0; i < numberOfChunks; i++){
+        chunks[i].first = first;
+        first += chunks[i].count;
+    }
+
+    if(first < expected){
+        fprintf(stderr, "Text matrix: expected %zu values, found %zu\n", expected, first);
+        free(chunks);
+        return 1;
+    }
+
+    runChunks(chunks, numberOfChunks, parseChunk);
+
+    for(i = 0; i < numberOfChunks; i++){
+        failed |= chunks[i].failed;
+    }
+
+    if(failed)
+        fprintf(stderr, "Text matrix: invalid value\n");
+
+    free(chunks);
+
+    return failed;
+}
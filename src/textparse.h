@@ -0,0 +1,71 @@
+#ifndef TEXTPARSE_H
+#define TEXTPARSE_H
+
+#include <stddef.h>
+
+/**
+ * Multi-threaded loader for the text format used in matrices/
+ *
+ *   J_ORDER J_ROW_TEST J_ERROR J_ITE_MAX
+ *   A (J_ORDER x J_ORDER values, row by row)
+ *   B (J_ORDER values)
+ *
+ * The file is mapped and the body is split in chunks at whitespace
+ * boundaries. A first parallel pass counts the values of each chunk, so every
+ * thread knows the index of its first value, and a second pass parses the
+ * values and writes them straight to their final position in A or B.
+ */
+typedef struct {
+
+    const char *text;
+    size_t size;
+    size_t bodyStart;
+    int order;
+    int rowTest;
+    double error;
+    int iteMax;
+
+} TextMatrix;
+
+/**
+ * Map the file and read the four metadata values
+ * Returns 0 on success, 1 on failure (a message is printed to stderr)
+ */
+int openTextMatrix(int fd, TextMatrix *matrix);
+
+/**
+ * Parse A and B using up to numberOfThreads threads
+ *
+ * A: J_ORDER rows, row i starts at A + i * lda
+ * b: J_ORDER values
+ *
+ * Returns 0 on success, 1 if the file is truncated or has an invalid value
+ */
+int parseTextMatrix(const TextMatrix *matrix, double *A, int lda, double *b, int numberOfThreads);
+
+/**
+ * parseTextMatrix keeping only the rows [firstRow, firstRow + rows) of A,
+ * row firstRow at A. The other values are checked for count only, B is
+ * always read whole
+ */
+int parseTextRows(const TextMatrix *matrix, int firstRow, int rows, double *A, int lda,
+        double *b, int numberOfThreads);
+
+/**
+ * Release the mapping created by openTextMatrix
+ */
+void closeTextMatrix(TextMatrix *matrix);
+
+/**
+ * Number of threads used to load matrices: the JR_LOAD_THREADS environment
+ * variable or the number of online processors
+ */
+int loaderThreads(void);
+
+/**
+ * Locale-free parser for a single floating point value in [p, end)
+ * Returns the number of characters consumed, 0 if there is no valid number
+ */
+size_t parseDouble(const char *p, const char *end, double *value);
+
+#endif
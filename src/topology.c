@@ -0,0 +1,171 @@
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <malloc.h>
+#include <dirent.h>
+
+#include "topology.h"
+
+// Allocations at least this big are always mapped (placeOnFirstTouch)
+#define FIRST_TOUCH_THRESHOLD (1 << 20)
+
+/**
+ * Parse a sysfs CPU list like "0-3,8-11" into set
+ */
+static void readCpuList(const char *path, cpu_set_t *set){
+
+    FILE *file;
+    int first, last, cpu;
+    char separator;
+
+    CPU_ZERO(set);
+
+    file = fopen(path, "r");
+    if(file == NULL)
+        return;
+
+    while(fscanf(file, "%d", &first) == 1){
+        last = first;
+        separator = (char) fgetc(file);
+        if(separator == '-'){
+            if(fscanf(file, "%d", &last) != 1)
+                break;
+            separator = (char) fgetc(file);
+        }
+        for(cpu = first; cpu <= last && cpu < CPU_SETSIZE; cpu++){
+            CPU_SET(cpu, set);
+        }
+        if(separator != ',')
+            break;
+    }
+
+    fclose(file);
+}
+
+void readTopology(Topology *topology, int numberOfThreads){
+
+    int i, k, n, cpu;
+    int found;
+    int nodeCount = 0;
+    int nodeIds[CPU_SETSIZE];
+    cpu_set_t allowed;
+    cpu_set_t *nodeCpus;
+    char path[64];
+    DIR *dir;
+    struct dirent *entry;
+
+    CPU_ZERO(&allowed);
+    sched_getaffinity(0, sizeof(cpu_set_t), &allowed);
+
+    // CPUs of each node directory, node0 to nodeN
+    nodeCpus = (cpu_set_t*) malloc(sizeof(cpu_set_t) * CPU_SETSIZE);
+    dir = opendir("/sys/devices/system/node");
+    if(dir != NULL){
+        while((entry = readdir(dir)) != NULL && nodeCount < CPU_SETSIZE){
+            if(strncmp(entry->d_name, "node", 4) != 0 || sscanf(entry->d_name + 4, "%d", &n) != 1)
+                continue;
+
+            snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", n);
+            readCpuList(path, &nodeCpus[nodeCount]);
+            CPU_AND(&nodeCpus[nodeCount], &nodeCpus[nodeCount], &allowed);
+            if(CPU_COUNT(&nodeCpus[nodeCount]) == 0)
+                continue;
+
+            nodeIds[nodeCount] = n;
+            nodeCount++;
+        }
+        closedir(dir);
+    }
+
+    // No NUMA information, a single node with every allowed CPU
+    if(nodeCount == 0){
+        nodeCpus[0] = allowed;
+        nodeIds[0] = 0;
+        nodeCount = 1;
+    }
+
+    topology->nodes = nodeCount;
+    topology->cpus = CPU_COUNT(&allowed);
+    topology->cpu = (int*) malloc(sizeof(int) * (topology->cpus + 1));
+    topology->node = (int*) malloc(sizeof(int) * (topology->cpus + 1));
+
+    // The k-th CPU of every node, then the (k+1)-th one
+    topology->cpus = 0;
+    for(k = 0, found = 1; found; k++){
+        found = 0;
+        for(i = 0; i < nodeCount; i++){
+            n = 0;
+            for(cpu = 0; cpu < CPU_SETSIZE; cpu++){
+                if(!CPU_ISSET(cpu, &nodeCpus[i]))
+                    continue;
+                if(n++ == k)
+                    break;
+            }
+            if(cpu == CPU_SETSIZE)
+                continue;
+
+            topology->cpu[topology->cpus] = cpu;
+            topology->node[topology->cpus] = nodeIds[i];
+            topology->cpus++;
+            found = 1;
+        }
+    }
+
+    topology->numberOfThreads = numberOfThreads;
+    topology->threadCpu = (int*) malloc(sizeof(int) * numberOfThreads);
+    for(i = 0; i < numberOfThreads; i++){
+        topology->threadCpu[i] = -1;
+    }
+
+    free(nodeCpus);
+}
+
+int pinThread(Topology *topology, int thread){
+
+    int k;
+    cpu_set_t set;
+
+    if(topology->cpus == 0)
+        return 1;
+
+    k = thread % topology->cpus;
+    CPU_ZERO(&set);
+    CPU_SET(topology->cpu[k], &set);
+    if(sched_setaffinity(0, sizeof(cpu_set_t), &set) != 0)
+        return 1;
+
+    topology->threadCpu[thread] = k;
+
+    return 0;
+}
+
+void printTopology(FILE *file, const Topology *topology){
+
+    int t, k;
+
+    fprintf(file, "Topology: %d nodes, %d CPUs\n", topology->nodes, topology->cpus);
+    for(t = 0; t < topology->numberOfThreads; t++){
+        k = topology->threadCpu[t];
+        if(k < 0)
+            fprintf(file, "Thread %d: not pinned\n", t);
+        else
+            fprintf(file, "Thread %d: cpu %d, node %d\n", t, topology->cpu[k], topology->node[k]);
+    }
+}
+
+void placeOnFirstTouch(void){
+
+    // A fixed threshold also turns off the dynamic one, which would start
+    // reusing freed matrices from the heap
+    mallopt(M_MMAP_THRESHOLD, FIRST_TOUCH_THRESHOLD);
+}
+
+void freeTopology(Topology *topology){
+
+    free(topology->cpu);
+    free(topology->node);
+    free(topology->threadCpu);
+
+    memset(topology, 0, sizeof(Topology));
+}
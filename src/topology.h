@@ -0,0 +1,61 @@
+#ifndef TOPOLOGY_H
+#define TOPOLOGY_H
+
+#include <stdio.h>
+
+/**
+ * CPUs and NUMA nodes the solver may run on, read from sysfs
+ *
+ * Linux places a page on the node of the thread that touches it first. The
+ * rows of Matrix A read by a thread should be touched by that same thread,
+ * pinned to one CPU, so they stay on its node for the whole solve instead of
+ * all of them landing on the node of the thread that read the file.
+ *
+ * Only the CPUs the process is allowed to use (taskset, cgroups) are taken.
+ * Without /sys/devices/system/node every CPU is put in node 0, which is also
+ * what a single-node machine reports.
+ *
+ * nodes: Number of nodes with at least one usable CPU
+ * cpus: Number of usable CPUs
+ * cpu/node: Usable CPUs and their node, taken from each node in turn so
+ * consecutive threads are spread over the nodes
+ * numberOfThreads: Threads that may be pinned
+ * threadCpu: Index in cpu/node of the CPU each thread was pinned to, -1 if
+ * it is not pinned
+ */
+typedef struct {
+
+    int nodes;
+    int cpus;
+    int *cpu;
+    int *node;
+    int numberOfThreads;
+    int *threadCpu;
+
+} Topology;
+
+/**
+ * Read the topology for numberOfThreads threads
+ */
+void readTopology(Topology *topology, int numberOfThreads);
+
+/**
+ * Pin the calling thread to cpu[thread % cpus]. Returns 0 on success
+ */
+int pinThread(Topology *topology, int thread);
+
+/**
+ * Write the nodes, CPUs and the CPU and node of every thread
+ */
+void printTopology(FILE *file, const Topology *topology);
+
+/**
+ * Make every large allocation come straight from fresh pages and go back to
+ * the system when freed, so the first touch after it decides its node. By
+ * default malloc may hand out memory already touched by another thread
+ */
+void placeOnFirstTouch(void);
+
+void freeTopology(Topology *topology);
+
+#endif
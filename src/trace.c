@@ -0,0 +1,188 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "solver.h"
+#include "trace.h"
+
+// Events a thread keeps per solve
+#define TRACE_EVENTS (1 << 18)
+
+/**
+ * A span (duration) or counter (value) event, times in seconds since the
+ * trace file was opened
+ */
+typedef struct {
+    const char *name;
+    double start;
+    double value;
+    int counter;
+} TraceEvent;
+
+/**
+ * Events of a thread, one cache line of bookkeeping each
+ */
+typedef struct {
+    TraceEvent *events;
+    int count;
+    int dropped;
+    char padding[64 - sizeof(TraceEvent*) - 2 * sizeof(int)];
+} __attribute__((aligned(64))) TraceBuffer;
+
+static FILE *traceFile;
+static struct timespec origin;
+static TraceBuffer *buffers;
+static int allocated;
+static int threads;
+static int solves;
+
+double traceNow(void){
+
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return elapsedTime(origin, now);
+}
+
+int traceOpen(void){
+
+    const char *path = getenv("JR_TRACE_FILE");
+
+    if(traceFile != NULL)
+        return 0;
+
+    if(path == NULL)
+        path = "trace.json";
+
+    traceFile = fopen(path, "w");
+    if(traceFile == NULL){
+        fprintf(stderr, "Could not open the trace file %s\n", path);
+        return 1;
+    }
+
+    // JSON array format, the closing bracket is optional
+    fprintf(traceFile, "[\n");
+    clock_gettime(CLOCK_MONOTONIC, &origin);
+
+    return 0;
+}
+
+void traceStart(int numberOfThreads){
+
+    int t;
+
+    if(numberOfThreads > allocated){
+        for(t = 0; t < allocated; t++){
+            free(buffers[t].events);
+        }
+        free(buffers);
+
+        posix_memalign((void**) &buffers, sizeof(TraceBuffer), sizeof(TraceBuffer) * numberOfThreads);
+        for(t = 0; t < numberOfThreads; t++){
+            buffers[t].events = (TraceEvent*) malloc(sizeof(TraceEvent) * TRACE_EVENTS);
+        }
+        allocated = numberOfThreads;
+    }
+
+    for(t = 0; t < numberOfThreads; t++){
+        buffers[t].count = 0;
+        buffers[t].dropped = 0;
+    }
+    threads = numberOfThreads;
+}
+
+/**
+ * Next free event of the thread, NULL if its buffer is full
+ */
+static TraceEvent* nextEvent(int thread){
+
+    TraceBuffer *buffer = &buffers[thread];
+
+    if(buffer->count == TRACE_EVENTS){
+        buffer->dropped++;
+        return NULL;
+    }
+
+    return &buffer->events[buffer->count++];
+}
+
+void traceSpan(int thread, const char *name, double begin){
+
+    double end = traceNow();
+    TraceEvent *event = nextEvent(thread);
+
+    if(event == NULL)
+        return;
+
+    event->name = name;
+    event->start = begin;
+    event->value = end - begin;
+    event->counter = 0;
+}
+
+void traceCounter(int thread, const char *name, double value){
+
+    double now = traceNow();
+    TraceEvent *event = nextEvent(thread);
+
+    if(event == NULL)
+        return;
+
+    event->name = name;
+    event->start = now;
+    event->value = value;
+    event->counter = 1;
+}
+
+void traceFinish(const char *engine){
+
+    int t, e;
+    long events = 0;
+    long dropped = 0;
+    TraceEvent *event;
+
+    solves++;
+    fprintf(traceFile, "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": %d, "
+            "\"args\": {\"name\": \"solve %d (%s)\"}},\n", solves, solves, engine);
+
+    for(t = 0; t < threads; t++){
+        fprintf(traceFile, "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": %d, \"tid\": %d, "
+                "\"args\": {\"name\": \"thread %d\"}},\n", solves, t, t);
+
+        for(e = 0; e < buffers[t].count; e++){
+            event = &buffers[t].events[e];
+            if(event->counter)
+                fprintf(traceFile, "{\"name\": \"%s\", \"ph\": \"C\", \"ts\": %.3f, \"pid\": %d, "
+                        "\"args\": {\"%s\": %e}},\n", event->name, event->start * 1e6, solves,
+                        event->name, event->value);
+            else
+                fprintf(traceFile, "{\"name\": \"%s\", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, "
+                        "\"pid\": %d, \"tid\": %d},\n", event->name, event->start * 1e6,
+                        event->value * 1e6, solves, t);
+        }
+
+        events = events + buffers[t].count;
+        dropped = dropped + buffers[t].dropped;
+    }
+
+    fprintf(outputFile, "Trace: %ld events, %ld dropped\n", events, dropped);
+}
+
+void traceClose(void){
+
+    int t;
+
+    if(traceFile != NULL){
+        fprintf(traceFile, "{}]\n");
+        fclose(traceFile);
+        traceFile = NULL;
+    }
+
+    for(t = 0; t < allocated; t++){
+        free(buffers[t].events);
+    }
+    free(buffers);
+    buffers = NULL;
+    allocated = 0;
+}
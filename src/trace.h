@@ -0,0 +1,87 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+/**
+ * Instrumentation of the iteration loops, in the Chrome trace format
+ * (chrome://tracing, ui.perfetto.dev)
+ *
+ * Only built with -DJR_TRACE=ON (CMake), otherwise every TRACE_ macro expands
+ * to nothing and the loops carry no timing calls at all. A traced build
+ * writes every solve to JR_TRACE_FILE, trace.json by default: each solve is a
+ * process and each thread of the engine a thread of it, with
+ *
+ *   sweep: The rows of the thread multiplied by x
+ *   barrier: Wait for the other threads, twice per iteration
+ *   check: Swap of x and max of the errors of the threads (openmp: also
+ *   x(k+1) from the products, on thread 0)
+ *   error: Counter with the max error of each iteration
+ *
+ * An --async solve has no barrier or check, each thread records its sweeps
+ * and the error of each of them.
+ *
+ * The file is created by jrInit, which fails if it can not be written. The
+ * events are kept in per-thread buffers during the solve and written once it
+ * is over, so the only cost in the loop is reading the clock.
+ * A thread keeps at most TRACE_EVENTS events per solve, the rest are
+ * counted as dropped.
+ */
+
+#ifdef JR_TRACE
+
+/**
+ * Create the trace file, JR_TRACE_FILE or trace.json. Returns 0 on success,
+ * 1 if it can not be written
+ */
+int traceOpen(void);
+
+/**
+ * Clear the buffers of numberOfThreads threads before a solve
+ */
+void traceStart(int numberOfThreads);
+
+/**
+ * Write the events of the solve to the trace file, named after the engine
+ */
+void traceFinish(const char *engine);
+
+/**
+ * Terminate and close the trace file
+ */
+void traceClose(void);
+
+/**
+ * Seconds since the trace file was opened
+ */
+double traceNow(void);
+
+/**
+ * Event of thread from begin (traceNow) to now
+ */
+void traceSpan(int thread, const char *name, double begin);
+
+/**
+ * Value of a counter, recorded now on thread
+ */
+void traceCounter(int thread, const char *name, double value);
+
+#define TRACE_OPEN() traceOpen()
+#define TRACE_START(threads) traceStart(threads)
+#define TRACE_FINISH(engine) traceFinish(engine)
+#define TRACE_CLOSE() traceClose()
+#define TRACE_BEGIN(clock) double clock = traceNow()
+#define TRACE_END(thread, name, clock) traceSpan(thread, name, clock)
+#define TRACE_COUNTER(thread, name, value) traceCounter(thread, name, value)
+
+#else
+
+#define TRACE_OPEN() 0
+#define TRACE_START(threads)
+#define TRACE_FINISH(engine)
+#define TRACE_CLOSE()
+#define TRACE_BEGIN(clock)
+#define TRACE_END(thread, name, clock)
+#define TRACE_COUNTER(thread, name, value)
+
+#endif
+
+#endif
@@ -0,0 +1,359 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "tune.h"
+
+// Iterations of the probe that sizes the trials
+#define PROBE_ITERATIONS 3
+
+// Length aimed at for each trial, in seconds, and its bounds in iterations
+#define TRIAL_SECONDS 0.02
+#define MIN_TRIAL_ITERATIONS 3
+#define MAX_TRIAL_ITERATIONS 200
+
+// Each configuration is timed this many times, the fastest one counts
+#define TRIAL_REPEATS 2
+
+#define HOST_LENGTH 64
+
+/**
+ * Configuration found by the trials
+ * seconds: Time per iteration of its best trial
+ */
+typedef struct {
+
+    const Kernel *kernel;
+    int threads;
+    Partition partition;
+    double seconds;
+
+} Tuning;
+
+static const char *partitionNames[] = { "balanced", "aligned" };
+static const char *precisionNames[] = { "double", "mixed", "check" };
+static const char *methodNames[] = { "jacobi", "gauss-seidel", "sor", "chebyshev" };
+
+#define PARTITIONS ((int) (sizeof(partitionNames) / sizeof(partitionNames[0])))
+
+// The configuration was tuned or read from the cache, no trials needed
+static int tuned;
+
+// Storage of Matrix A the configuration was tuned for
+static const char *tunedStorage;
+
+/**
+ * Iteration the solves run: --method, or async for asynchronous Jacobi
+ */
+static const char* methodName(void){
+
+    return options.async ? "async" : methodNames[options.method];
+}
+
+/**
+ * Path of the tuning cache, 1 if there is none (no JR_TUNE_CACHE nor HOME)
+ */
+static int cachePath(char *path, size_t size){
+
+    const char *env = getenv("JR_TUNE_CACHE");
+    const char *home = getenv("HOME");
+
+    if(env != NULL){
+        snprintf(path, size, "%s", env);
+        return 0;
+    }
+
+    if(home == NULL)
+        return 1;
+
+    snprintf(path, size, "%s/.cache", home);
+    mkdir(path, 0755);
+    snprintf(path, size, "%s/.cache/jacobi-tune", home);
+
+    return 0;
+}
+
+static void hostName(char *host){
+
+    if(gethostname(host, HOST_LENGTH) != 0)
+        strcpy(host, "unknown");
+    host[HOST_LENGTH - 1] = '\0';
+}
+
+/**
+ * Last entry of the cache for this host, order, engine, storage, precision
+ * and method. Entries naming a kernel this CPU does not support are skipped
+ */
+static int readTuning(int order, const Engine *engine, const char *storage, Tuning *tuning){
+
+    FILE *file;
+    char path[PATH_MAX];
+    char line[512];
+    char host[HOST_LENGTH], lineHost[HOST_LENGTH];
+    char lineEngine[32], lineStorage[32], linePrecision[32], lineMethod[32];
+    char kernelName[32], partitionName[32];
+    int lineOrder, threads, p;
+    double seconds;
+    const Kernel *lineKernel;
+    int found = 0;
+
+    if(cachePath(path, sizeof(path)) != 0)
+        return 0;
+
+    file = fopen(path, "r");
+    if(file == NULL)
+        return 0;
+
+    hostName(host);
+    while(fgets(line, sizeof(line), file) != NULL){
+        if(sscanf(line, "%63s %d %31s %31s %31s %31s %31s %d %31s %lf", lineHost, &lineOrder,
+                    lineEngine, lineStorage, linePrecision, lineMethod, kernelName, &threads,
+                    partitionName, &seconds) != 10)
+            continue;
+
+        if(strcmp(lineHost, host) != 0 || lineOrder != order || strcmp(lineEngine, engine->name) != 0
+                || strcmp(lineStorage, storage) != 0
+                || strcmp(linePrecision, precisionNames[options.precision]) != 0
+                || strcmp(lineMethod, methodName()) != 0)
+            continue;
+
+        for(p = 0; p < PARTITIONS && strcmp(partitionNames[p], partitionName) != 0; p++);
+        lineKernel = findKernel(kernelName);
+        if(p == PARTITIONS || lineKernel == NULL || threads <= 0)
+            continue;
+
+        tuning->kernel = lineKernel;
+        tuning->threads = threads;
+        tuning->partition = (Partition) p;
+        tuning->seconds = seconds;
+        found = 1;
+    }
+
+    fclose(file);
+
+    return found;
+}
+
+/**
+ * Replace the entry for this host, order, engine, storage, precision and
+ * method, or add it. The cache is rewritten to a temporary file that takes
+ * its place
+ */
+static void writeTuning(int order, const Engine *engine, const char *storage, const Tuning *tuning){
+
+    FILE *in, *out;
+    char path[PATH_MAX];
+    char temp[PATH_MAX + 8];
+    char line[512];
+    char host[HOST_LENGTH], lineHost[HOST_LENGTH];
+    char lineEngine[32], lineStorage[32], linePrecision[32], lineMethod[32];
+    int lineOrder;
+
+    if(cachePath(path, sizeof(path)) != 0)
+        return;
+
+    snprintf(temp, sizeof(temp), "%s.tmp", path);
+    out = fopen(temp, "w");
+    if(out == NULL){
+        fprintf(stderr, "Could not write the tuning cache %s\n", temp);
+        return;
+    }
+
+    hostName(host);
+    in = fopen(path, "r");
+    if(in != NULL){
+        while(fgets(line, sizeof(line), in) != NULL){
+            if(sscanf(line, "%63s %d %31s %31s %31s %31s", lineHost, &lineOrder, lineEngine,
+                        lineStorage, linePrecision, lineMethod) == 6 &&
+                    strcmp(lineHost, host) == 0 && lineOrder == order &&
+                    strcmp(lineEngine, engine->name) == 0 && strcmp(lineStorage, storage) == 0 &&
+                    strcmp(linePrecision, precisionNames[options.precision]) == 0 &&
+                    strcmp(lineMethod, methodName()) == 0)
+                continue;
+
+            fputs(line, out);
+        }
+        fclose(in);
+    }
+
+    fprintf(out, "%s %d %s %s %s %s %s %d %s %e\n", host, order, engine->name, storage,
+            precisionNames[options.precision], methodName(), tuning->kernel->name,
+            tuning->threads, partitionNames[tuning->partition], tuning->seconds);
+    fclose(out);
+
+    if(rename(temp, path) != 0)
+        fprintf(stderr, "Could not write the tuning cache %s\n", path);
+}
+
+/**
+ * Make the next solves use the configuration
+ */
+static void applyTuning(const Engine *engine, const Tuning *tuning){
+
+    kernel = tuning->kernel;
+    options.partition = tuning->partition;
+    if(engine->resize != NULL){
+        engine->resize(tuning->threads);
+        options.numberOfThreads = tuning->threads;
+    }
+}
+
+int loadTuning(Data *data, const Engine *engine){
+
+    Tuning tuning;
+    const char *storage = storageName(data);
+
+    // A text matrix is still dense here, --storage sparse converts it later
+    if(options.storage == STORAGE_SPARSE)
+        storage = "sparse";
+
+    if(options.tune != TUNE_ON || !readTuning(data->J_ORDER, engine, storage, &tuning))
+        return 0;
+
+    // The engine is not started yet, it takes the threads from options
+    kernel = tuning.kernel;
+    options.partition = tuning.partition;
+    if(engine->resize != NULL)
+        options.numberOfThreads = tuning.threads;
+
+    fprintf(outputFile, "Tuned: kernel %s, %d threads, %s partition, %e s/iteration (cached)\n",
+            tuning.kernel->name, tuning.threads, partitionNames[tuning.partition], tuning.seconds);
+    tuned = 1;
+    tunedStorage = storage;
+
+    return 1;
+}
+
+/**
+ * Best time per iteration of TRIAL_REPEATS solves
+ */
+static double timeTrial(Data *data){
+
+    int r;
+    double seconds;
+    double best = -1;
+
+    for(r = 0; r < TRIAL_REPEATS; r++){
+        iterations = 0;
+        data->engine->solve(data);
+
+        seconds = timeSpent / (iterations > 0 ? iterations : 1);
+        if(best < 0 || seconds < best)
+            best = seconds;
+    }
+
+    return best;
+}
+
+/**
+ * Next number of threads to try after threads: the powers of two below
+ * maxThreads, then maxThreads itself. 0 once it is reached
+ */
+static int nextThreads(int threads, int maxThreads){
+
+    if(threads >= maxThreads)
+        return 0;
+
+    return threads * 2 < maxThreads ? threads * 2 : maxThreads;
+}
+
+void tuneProblem(Data *data){
+
+    const Engine *engine = data->engine;
+    const Kernel *trialKernel;
+    FILE *report = outputFile;
+    Tuning best, trial;
+    int maxThreads = engine->threads();
+    int iteMax = data->J_ITE_MAX;
+    double error = data->J_ERROR;
+    int fixedKernel = getenv("JR_KERNEL") != NULL;
+    Partition partition = options.partition;
+    Checkpoint *checkpoint = data->checkpoint;
+    int trials = 0;
+    int trialIterations;
+    double probe;
+    int p;
+
+    if(options.tune == TUNE_OFF)
+        return;
+
+    if(tuned && strcmp(tunedStorage, storageName(data)) == 0)
+        return;
+
+    // A text matrix is read dense and --storage auto may turn it sparse after
+    // the engine started with the configuration cached for the dense one
+    if(options.tune == TUNE_ON && readTuning(data->J_ORDER, engine, storageName(data), &best)){
+        applyTuning(engine, &best);
+        tuned = 1;
+        tunedStorage = storageName(data);
+        fprintf(outputFile, "Tuned: kernel %s, %d threads, %s partition, %e s/iteration (cached)\n",
+                best.kernel->name, best.threads, partitionNames[best.partition], best.seconds);
+        return;
+    }
+
+    // The trials are not reported like solves, only their times
+    outputFile = fopen("/dev/null", "w");
+    if(outputFile == NULL){
+        outputFile = report;
+        fprintf(stderr, "Could not open /dev/null for the tuning trials, solving untuned\n");
+        return;
+    }
+
+    // Every trial runs all of its iterations from x = 0, without saving them
+    data->J_ERROR = 0;
+    data->checkpoint = NULL;
+
+    data->J_ITE_MAX = PROBE_ITERATIONS;
+    probe = timeTrial(data);
+    trialIterations = probe > 0 ? (int) (TRIAL_SECONDS / probe) : MAX_TRIAL_ITERATIONS;
+    if(trialIterations < MIN_TRIAL_ITERATIONS)
+        trialIterations = MIN_TRIAL_ITERATIONS;
+    if(trialIterations > MAX_TRIAL_ITERATIONS)
+        trialIterations = MAX_TRIAL_ITERATIONS;
+    if(trialIterations > iteMax)
+        trialIterations = iteMax;
+    data->J_ITE_MAX = trialIterations;
+
+    best.seconds = -1;
+    for(trialKernel = fixedKernel ? kernel : nextKernel(NULL); trialKernel != NULL;
+            trialKernel = fixedKernel ? NULL : nextKernel(trialKernel)){
+
+        trial.threads = engine->resize != NULL ? 1 : maxThreads;
+        for(; trial.threads > 0; trial.threads = nextThreads(trial.threads, maxThreads)){
+
+            // A single block is the same for every partition, it keeps --partition
+            for(p = 0; p < (trial.threads > 1 ? PARTITIONS : 1); p++){
+                trial.kernel = trialKernel;
+                trial.partition = trial.threads > 1 ? (Partition) p : partition;
+                applyTuning(engine, &trial);
+
+                trial.seconds = timeTrial(data);
+                trials++;
+
+                fprintf(report, "Tune: kernel %s, %d threads, %s partition: %e s/iteration\n",
+                        trial.kernel->name, trial.threads, partitionNames[trial.partition], trial.seconds);
+
+                if(best.seconds < 0 || trial.seconds < best.seconds)
+                    best = trial;
+            }
+        }
+    }
+
+    fclose(outputFile);
+    outputFile = report;
+    data->J_ITE_MAX = iteMax;
+    data->J_ERROR = error;
+    data->checkpoint = checkpoint;
+
+    applyTuning(engine, &best);
+    writeTuning(data->J_ORDER, engine, storageName(data), &best);
+    tuned = 1;
+    tunedStorage = storageName(data);
+
+    fprintf(outputFile, "Tuned: kernel %s, %d threads, %s partition, %e s/iteration (%d trials of %d iterations)\n",
+            best.kernel->name, best.threads, partitionNames[best.partition], best.seconds,
+            trials, trialIterations);
+}
@@ -0,0 +1,39 @@
+#ifndef TUNE_H
+#define TUNE_H
+
+#include "solver.h"
+
+/**
+ * Autotuning of the kernel, number of threads and partition (--tune)
+ *
+ * Every supported kernel is tried with 1, 2, 4, ... threads up to the
+ * threads the engine started with, and each partition when there is more
+ * than one thread. A trial is a solve capped at a few iterations with
+ * J_ERROR 0, sized by a first probe so it lasts about 20 ms, timed twice;
+ * the fastest time per iteration wins. Engines with a single thread only
+ * try the kernels, and JR_KERNEL fixes the kernel.
+ *
+ * The winner is kept in a tuning cache, a text file with one line per host,
+ * order, engine, storage, precision and method (async for --async), as the
+ * kernel and the partition that win differ between them:
+ *
+ *     host order engine storage precision method kernel threads partition secondsPerIteration
+ *
+ * at JR_TUNE_CACHE, or ~/.cache/jacobi-tune by default. Later runs with
+ * --tune start the engine straight with the cached configuration.
+ */
+
+/**
+ * Apply the cached configuration for this loaded problem and engine, before
+ * the engine is started. Returns 1 if there was one
+ */
+int loadTuning(Data *data, const Engine *engine);
+
+/**
+ * Run the trials on a prepared problem, unless its configuration was already
+ * tuned or read from the cache for its storage, then apply and cache the
+ * fastest one
+ */
+void tuneProblem(Data *data);
+
+#endif